@@ -0,0 +1,213 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+
+#include "../src/cuerpos/contactos.h"
+#include "../src/cuerpos/formas.h"
+
+// Formas mezcladas en un mundo chico, para que una parte de los pares se
+// superponga, y pares candidatos al azar como los que deja la fase amplia
+struct Escena
+{
+    static constexpr int cantidad_de_formas = 10000;
+
+    Formas formas;
+    std::vector<IdDeForma> ids;
+    std::vector<std::unique_ptr<CuerpoRigido>> cuerpos;
+    std::vector<std::pair<int, int>> pares;
+
+    Escena(int cantidad_de_pares)
+    {
+        std::mt19937 generador(1);
+        std::uniform_real_distribution<float> posicion(-200.0f, 200.0f), medida(1.0f, 8.0f);
+
+        for (int i = 0; i < cantidad_de_formas; i++)
+        {
+            Vector2 centro(posicion(generador), posicion(generador));
+            switch (generador() % 3)
+            {
+            case 0:
+                agregar(Circulo(centro, medida(generador)));
+                break;
+            case 1:
+                agregar(Linea(centro, centro + Vector2(medida(generador), medida(generador))));
+                break;
+            default:
+                agregar(AABB(centro, medida(generador), medida(generador)));
+                break;
+            }
+        }
+
+        // Cada forma con una cercana en el orden de creacion, ya mezcladas en tipo
+        std::uniform_int_distribution<int> forma(0, cantidad_de_formas - 1), vecino(1, 64);
+        for (int i = 0; i < cantidad_de_pares; i++)
+        {
+            int a = forma(generador);
+            pares.emplace_back(a, (a + vecino(generador)) % cantidad_de_formas);
+        }
+    }
+
+    template <typename Cuerpo>
+    void agregar(Cuerpo cuerpo)
+    {
+        ids.push_back(formas.agregar(cuerpo));
+        cuerpos.emplace_back(std::make_unique<Cuerpo>(cuerpo));
+    }
+};
+
+static void BM_Interseccion_virtual(benchmark::State &state)
+{
+    Escena escena(state.range(0));
+
+    for (auto _ : state)
+    {
+        int superpuestos = 0;
+        for (auto [a, b] : escena.pares)
+            superpuestos += escena.cuerpos[a]->intersecta(escena.cuerpos[b].get());
+        benchmark::DoNotOptimize(superpuestos);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Interseccion_virtual)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Interseccion_por_tabla(benchmark::State &state)
+{
+    Escena escena(state.range(0));
+    std::vector<Forma> formas;
+    for (IdDeForma id : escena.ids)
+        formas.push_back(escena.formas.forma(id));
+
+    for (auto _ : state)
+    {
+        int superpuestos = 0;
+        for (auto [a, b] : escena.pares)
+            superpuestos += colision::intersecta(formas[a], formas[b]);
+        benchmark::DoNotOptimize(superpuestos);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Interseccion_por_tabla)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Incluye armar el lote, que en la simulacion se hace en cada paso
+static void BM_Interseccion_por_lote(benchmark::State &state)
+{
+    Escena escena(state.range(0));
+    LoteDePares lote;
+
+    for (auto _ : state)
+    {
+        lote.vaciar();
+        for (auto [a, b] : escena.pares)
+            lote.agregar(escena.ids[a], escena.ids[b]);
+
+        int superpuestos = 0;
+        lote.intersecciones(escena.formas, [&](IdDeForma, IdDeForma)
+                            { superpuestos++; });
+        benchmark::DoNotOptimize(superpuestos);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Interseccion_por_lote)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Colision_virtual(benchmark::State &state)
+{
+    Escena escena(state.range(0));
+
+    for (auto _ : state)
+    {
+        float distancia = .0f;
+        for (auto [a, b] : escena.pares)
+        {
+            PuntoDeColision punto = escena.cuerpos[a]->colisiona(escena.cuerpos[b].get());
+            if (punto.colisiono)
+                distancia += punto.distancia;
+        }
+        benchmark::DoNotOptimize(distancia);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Colision_virtual)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Colision_por_lote(benchmark::State &state)
+{
+    Escena escena(state.range(0));
+    LoteDePares lote;
+
+    for (auto _ : state)
+    {
+        lote.vaciar();
+        for (auto [a, b] : escena.pares)
+            lote.agregar(escena.ids[a], escena.ids[b]);
+
+        float distancia = .0f;
+        lote.colisiones(escena.formas, [&](IdDeForma, IdDeForma, PuntoDeColision punto)
+                        { distancia += punto.distancia; });
+        benchmark::DoNotOptimize(distancia);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Colision_por_lote)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Granos del mismo tamano, de a pares con uno cercano, como los de la arena
+struct ParesDeGranos
+{
+    std::vector<Circulo> circulos;
+    colision::ParesDeCirculos pares;
+
+    ParesDeGranos(int cantidad)
+    {
+        std::mt19937 generador(1);
+        std::uniform_real_distribution<float> posicion(-512.0f, 512.0f), cerca(-3.0f, 3.0f);
+
+        for (int i = 0; i < cantidad; i++)
+        {
+            Vector2 centro(posicion(generador), posicion(generador));
+            circulos.emplace_back(centro, 1.0f);
+            circulos.emplace_back(centro + Vector2(cerca(generador), cerca(generador)), 1.0f);
+        }
+        pares.reservar(cantidad);
+        for (int i = 0; i < cantidad; i++)
+            pares.agregar(circulos[2 * i], circulos[2 * i + 1]);
+    }
+};
+
+static void BM_Circulos_de_a_uno(benchmark::State &state)
+{
+    ParesDeGranos granos(state.range(0));
+
+    for (auto _ : state)
+    {
+        float penetracion = .0f;
+        for (int i = 0; i < state.range(0); i++)
+        {
+            PuntoDeColision punto = colision::colision_circulo_circulo(&granos.circulos[2 * i], &granos.circulos[2 * i + 1]);
+            if (punto.colisiono)
+                penetracion += punto.distancia;
+        }
+        benchmark::DoNotOptimize(penetracion);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Circulos_de_a_uno)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// El segundo argumento son las instrucciones: escalar, SSE o AVX2
+static void BM_Circulos_por_lote(benchmark::State &state)
+{
+    ParesDeGranos granos(state.range(0));
+    colision::ContactosDeCirculos contactos;
+    auto instrucciones = (colision::Instrucciones)state.range(1);
+    if (instrucciones > colision::instrucciones_disponibles())
+    {
+        state.SkipWithError("El procesador no soporta estas instrucciones");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        colision::colisiones_circulo_circulo(granos.pares, contactos, instrucciones);
+        benchmark::DoNotOptimize(contactos.penetracion.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Circulos_por_lote)->ArgsProduct({{100000}, {0, 1, 2}})->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,526 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "../src/quadtree.h"
+#include "../src/quadtreeHolgado.h"
+#include "../src/quadtreeLineal.h"
+
+class Grano : public qt::Entidad
+{
+public:
+    Circulo m_cuerpo;
+
+public:
+    Grano(Vector2 posicion, float radio)
+        : m_cuerpo(posicion, radio)
+    {
+    }
+
+    bool colisiona(CuerpoRigido *area)
+    {
+        return m_cuerpo.intersecta(area);
+    }
+
+    AABB limites()
+    {
+        return m_cuerpo.limites();
+    }
+};
+
+// Granos de arena repartidos uniformemente en un mundo de 1024 x 1024. Con
+// un radio maximo mayor a 1, uno de cada diez es una piedra de hasta ese radio
+struct Arena
+{
+    static constexpr float mitad = 512.0f;
+
+    std::vector<Grano *> granos;
+    unsigned semilla = 1;
+
+    Arena(int cantidad, float radio_maximo = 1.0f)
+    {
+        for (int i = 0; i < cantidad; i++)
+        {
+            Vector2 posicion(azar(-mitad, mitad), azar(-mitad, mitad));
+            float radio = (radio_maximo > 1.0f && i % 10 == 0) ? azar(1.0f, radio_maximo) : 1.0f;
+            granos.emplace_back(new Grano(posicion, radio));
+        }
+    }
+
+    ~Arena()
+    {
+        for (Grano *grano : granos)
+            delete grano;
+    }
+
+    float azar(float minimo, float maximo)
+    {
+        semilla = semilla * 1103515245u + 12345u;
+        return minimo + (maximo - minimo) * (float)((semilla >> 8) & 0xffff) / 65535.0f;
+    }
+
+    void mover(float paso)
+    {
+        for (Grano *grano : granos)
+        {
+            Vector2 &posicion = grano->m_cuerpo.m_posicion;
+            posicion.x = std::clamp(posicion.x + azar(-paso, paso), -mitad, mitad);
+            posicion.y = std::clamp(posicion.y + azar(-paso, paso), -mitad, mitad);
+        }
+    }
+};
+
+template <typename E, int Capacidad, int Profundidad>
+void preparar(qt::QuadTree<E, Capacidad, Profundidad> &)
+{
+}
+
+void preparar(qt::QuadTreeHolgado &)
+{
+}
+
+void preparar(qt::QuadTreeLineal &arbol)
+{
+    arbol.ordenar();
+}
+
+// Arg 0: cantidad de granos
+template <typename Arbol>
+static void BM_Construir(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    for (auto _ : state)
+    {
+        Arbol arbol(Vector2(), Arena::mitad, Arena::mitad);
+        for (Grano *grano : arena.granos)
+            arbol.insertar(grano);
+        preparar(arbol);
+        benchmark::DoNotOptimize(arbol);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Construir<qt::QuadTree<>>)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Construir<qt::QuadTreeHolgado>)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Construir<qt::QuadTreeLineal>)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// Cada cuadro todos los granos se mueven un poco y se actualizan. Arg 0:
+// cantidad de granos, arg 1: radio maximo
+template <typename Arbol>
+static void BM_Actualizar(benchmark::State &state)
+{
+    Arena arena(state.range(0), state.range(1));
+    Arbol arbol(Vector2(), Arena::mitad, Arena::mitad);
+    for (Grano *grano : arena.granos)
+        arbol.insertar(grano);
+    preparar(arbol);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        arena.mover(.5f);
+        state.ResumeTiming();
+
+        for (Grano *grano : arena.granos)
+            arbol.actualizar(grano);
+        preparar(arbol);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Actualizar<qt::QuadTree<>>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Actualizar<qt::QuadTreeHolgado>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Actualizar<qt::QuadTreeLineal>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+
+// Lo mismo que BM_Actualizar pero actualizando todos juntos. Arg 0: cantidad
+// de granos, arg 1: cantidad de hilos
+static void BM_Actualizar_en_lote(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+    omp_set_num_threads(state.range(1));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        arena.mover(.5f);
+        state.ResumeTiming();
+
+        arbol.actualizar_lote(entidades);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Actualizar_en_lote)->ArgsProduct({{1000, 10000}, {1, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Una busqueda de los vecinos de cada grano. Arg 0: cantidad de granos,
+// arg 1: radio maximo
+template <typename Arbol>
+static void BM_Buscar(benchmark::State &state)
+{
+    Arena arena(state.range(0), state.range(1));
+    Arbol arbol(Vector2(), Arena::mitad, Arena::mitad);
+    for (Grano *grano : arena.granos)
+        arbol.insertar(grano);
+    preparar(arbol);
+
+    std::pmr::vector<qt::Entidad *> vecinos;
+    for (auto _ : state)
+    {
+        for (Grano *grano : arena.granos)
+        {
+            Circulo alcance(grano->m_cuerpo.m_posicion, 8.0f);
+            vecinos.clear();
+            arbol.buscar(&alcance, vecinos);
+            benchmark::DoNotOptimize(vecinos.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Buscar<qt::QuadTree<>>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Buscar<qt::QuadTreeHolgado>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Buscar<qt::QuadTreeLineal>)->ArgsProduct({{1000, 10000}, {1, 32}})->Unit(benchmark::kMillisecond);
+
+// Busquedas grandes sobre arena densa, que devuelven cientos de granos cada
+// una. Arg 0: cantidad de granos, arg 1: radio de la busqueda
+template <typename Arbol>
+static void BM_Buscar_amplio(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    Arbol arbol(Vector2(), Arena::mitad, Arena::mitad);
+    for (Grano *grano : arena.granos)
+        arbol.insertar(grano);
+    preparar(arbol);
+
+    std::pmr::vector<qt::Entidad *> encontrados;
+    int64_t total = 0;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            Circulo alcance(arena.granos[i]->m_cuerpo.m_posicion, (float)state.range(1));
+            encontrados.clear();
+            arbol.buscar(&alcance, encontrados);
+            total += encontrados.size();
+        }
+    }
+    state.SetItemsProcessed(total);
+}
+BENCHMARK(BM_Buscar_amplio<qt::QuadTree<>>)->ArgsProduct({{100000}, {16, 64}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Buscar_amplio<qt::QuadTreeHolgado>)->ArgsProduct({{100000}, {16, 64}})->Unit(benchmark::kMillisecond);
+
+// Un cuadro completo, mover los granos, actualizarlos en lote y buscar los
+// vecinos de cada uno, con distintas capacidades de hoja para elegir la que
+// mejor anda con la densidad de la arena. Con Grano las pruebas se inlinean,
+// y con qt::Entidad pasan por la tabla virtual. Arg 0: cantidad de granos
+template <typename E, int Capacidad>
+static void BM_Cuadro(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    std::vector<E *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree<E, Capacidad> arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<E *> vecinos;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        arena.mover(.5f);
+        state.ResumeTiming();
+
+        arbol.actualizar_lote(entidades);
+        for (Grano *grano : arena.granos)
+        {
+            Circulo alcance(grano->m_cuerpo.m_posicion, 8.0f);
+            vecinos.clear();
+            arbol.buscar(&alcance, vecinos);
+            benchmark::DoNotOptimize(vecinos.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Cuadro<qt::Entidad, 4>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 1>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 2>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 4>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 8>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 16>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Cuadro<Grano, 32>)->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+
+// Comparacion de armar el arbol insertando de a una contra construirlo en
+// lote. Arg 0: cantidad de granos, arg 1: cantidad de hilos
+static void BM_Construir_de_a_una(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    for (auto _ : state)
+    {
+        qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+        for (Grano *grano : arena.granos)
+            arbol.insertar(grano);
+
+        state.PauseTiming();
+        for (Grano *grano : arena.granos)
+            grano->m_padres.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Construir_de_a_una)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_Construir_en_lote(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    omp_set_num_threads(state.range(1));
+
+    for (auto _ : state)
+    {
+        qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+        arbol.construir(entidades);
+
+        state.PauseTiming();
+        for (Grano *grano : arena.granos)
+            grano->m_padres.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Construir_en_lote)->ArgsProduct({{10000, 100000}, {1, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Todos los pares de granos que se tocan: una busqueda por grano contra un
+// solo recorrido del arbol. Arg 0: cantidad de granos
+static void BM_Pares_buscando(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<qt::Entidad *> vecinos;
+    for (auto _ : state)
+    {
+        int64_t pares = 0;
+        for (Grano *grano : arena.granos)
+        {
+            vecinos.clear();
+            arbol.buscar(&grano->m_cuerpo, vecinos);
+            for (qt::Entidad *vecino : vecinos)
+                pares += vecino < grano;
+        }
+        benchmark::DoNotOptimize(pares);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pares_buscando)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Arg 1: cantidad de hilos
+static void BM_Pares_en_colision(benchmark::State &state)
+{
+    Arena arena(state.range(0));
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+    omp_set_num_threads(state.range(1));
+
+    for (auto _ : state)
+    {
+        std::atomic<int64_t> pares = 0;
+        arbol.pares_en_colision([&pares](qt::Entidad *a, qt::Entidad *b)
+                                {
+                                    if (a->colisiona(&((Grano *)b)->m_cuerpo))
+                                        pares.fetch_add(1, std::memory_order_relaxed); });
+        benchmark::DoNotOptimize(pares.load());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pares_en_colision)->ArgsProduct({{10000, 100000}, {1, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Preguntar si hay algun grano cerca de cada uno de los primeros 1000, con
+// 100000 granos. Arg 0: radio de la busqueda
+static void BM_Hay_alguno_en_lista(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<qt::Entidad *> encontrados;
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            Circulo alcance(arena.granos[i]->m_cuerpo.m_posicion, (float)state.range(0));
+            encontrados.clear();
+            arbol.buscar(&alcance, encontrados);
+            benchmark::DoNotOptimize(encontrados.size() > 1);
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Hay_alguno_en_lista)->Arg(4)->Arg(32)->Unit(benchmark::kMillisecond);
+
+static void BM_Hay_alguno_con_visitante(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            Grano *grano = arena.granos[i];
+            Circulo alcance(grano->m_cuerpo.m_posicion, (float)state.range(0));
+            bool hay = !arbol.buscar(&alcance, [grano](qt::Entidad *e)
+                                     { return e == grano; });
+            benchmark::DoNotOptimize(hay);
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Hay_alguno_con_visitante)->Arg(4)->Arg(32)->Unit(benchmark::kMillisecond);
+
+static void BM_Hay_alguno_con_generador(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            Grano *grano = arena.granos[i];
+            Circulo alcance(grano->m_cuerpo.m_posicion, (float)state.range(0));
+            bool hay = false;
+            for (qt::Entidad *e : arbol.entidades_en(&alcance))
+                if (e != grano)
+                {
+                    hay = true;
+                    break;
+                }
+            benchmark::DoNotOptimize(hay);
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Hay_alguno_con_generador)->Arg(4)->Arg(32)->Unit(benchmark::kMillisecond);
+
+// Los vecinos a menos de un radio de cada uno de los primeros 1000 granos,
+// ordenados por distancia, con 100000 granos. Arg 0: radio
+static void BM_Radio_buscando_y_filtrando(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    const float radio = (float)state.range(0);
+    std::pmr::vector<qt::Entidad *> encontrados;
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            Vector2 centro = arena.granos[i]->m_cuerpo.m_posicion;
+            Circulo alcance(centro, radio);
+            encontrados.clear();
+            arbol.buscar(&alcance, encontrados);
+
+            std::erase_if(encontrados, [centro, radio](qt::Entidad *e)
+                          { return centro.distancia_cuadrada(((Grano *)e)->m_cuerpo.m_posicion) > radio * radio; });
+            std::sort(encontrados.begin(), encontrados.end(), [centro](qt::Entidad *a, qt::Entidad *b)
+                      { return centro.distancia_cuadrada(((Grano *)a)->m_cuerpo.m_posicion) <
+                               centro.distancia_cuadrada(((Grano *)b)->m_cuerpo.m_posicion); });
+            benchmark::DoNotOptimize(encontrados.data());
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Radio_buscando_y_filtrando)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond);
+
+static void BM_Buscar_radio(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<qt::Entidad *> encontrados;
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            encontrados.clear();
+            arbol.buscar_radio(arena.granos[i]->m_cuerpo.m_posicion, (float)state.range(0), encontrados);
+            benchmark::DoNotOptimize(encontrados.data());
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Buscar_radio)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond);
+
+// Los k mas cercanos a cada uno de los primeros 1000 granos. Arg 0: k
+static void BM_K_vecinos(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<qt::Entidad *> encontrados;
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            encontrados.clear();
+            arbol.k_vecinos(arena.granos[i]->m_cuerpo.m_posicion, state.range(0), encontrados);
+            benchmark::DoNotOptimize(encontrados.data());
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_K_vecinos)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond);
+
+// Rayos de 256 de largo desde cada uno de los primeros 1000 granos, con
+// 100000 granos: el impacto mas cercano buscando todo lo que toca el
+// segmento, contra recorrer de adelante hacia atras
+static void BM_Rayo_buscando(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    std::pmr::vector<qt::Entidad *> encontrados;
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            Vector2 origen = arena.granos[i]->m_cuerpo.m_posicion;
+            Vector2 direccion(256.0f, 128.0f * (float)(i % 3) - 128.0f);
+            Linea segmento(origen, origen + direccion);
+            encontrados.clear();
+            arbol.buscar(&segmento, encontrados);
+
+            float mas_cerca = 1.0f;
+            for (qt::Entidad *e : encontrados)
+            {
+                PuntoDeColision punto = e->cortar(&segmento);
+                if (punto.colisiono && e != arena.granos[i])
+                    mas_cerca = std::min(mas_cerca, ((punto.A - origen) * direccion) / (direccion * direccion));
+            }
+            benchmark::DoNotOptimize(mas_cerca);
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Rayo_buscando)->Unit(benchmark::kMillisecond);
+
+static void BM_Raycast(benchmark::State &state)
+{
+    Arena arena(100000);
+    std::vector<qt::Entidad *> entidades(arena.granos.begin(), arena.granos.end());
+    qt::QuadTree arbol(Vector2(), Arena::mitad, Arena::mitad);
+    arbol.construir(entidades);
+
+    for (auto _ : state)
+        for (int i = 0; i < 1000; i++)
+        {
+            // Desde afuera del grano, para no chocar con si mismo
+            Vector2 origen = arena.granos[i]->m_cuerpo.m_posicion + Vector2(1.5f, .0f);
+            Vector2 direccion(256.0f, 128.0f * (float)(i % 3) - 128.0f);
+            qt::Impacto impacto = arbol.raycast(origen, direccion);
+            benchmark::DoNotOptimize(impacto);
+        }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Raycast)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
+#include "../src/sistema.h"
+
+using namespace sistema;
+
+struct Pila
+{
+    std::vector<Particula *> particulas;
+    int filas, columnas;
+
+    Pila(int filas, int columnas, bool quieta = false)
+        : filas(filas), columnas(columnas)
+    {
+        for (int i = 0; i < filas * columnas; i++)
+        {
+            Vector2 velocidad((float)(i * 7 % 5) - 2.0f, (float)(i * 3 % 4) - 2.0f);
+            velocidad *= quieta ? .0f : 1.0f;
+            particulas.emplace_back(new Particula(1.0f + (float)(i % 3), velocidad, Vector2(.0f, -10.0f), .5f));
+        }
+        particulas.emplace_back(new Particula());
+    }
+
+    ~Pila()
+    {
+        for (Particula *particula : particulas)
+            delete particula;
+    }
+
+    void conectar(Sistema &sistema)
+    {
+        int piso = filas * columnas;
+        for (int fila = 0; fila < filas; fila++)
+            for (int columna = 0; columna < columnas; columna++)
+            {
+                int indice = fila * columnas + columna;
+                if (columna + 1 < columnas)
+                    sistema.agregar_interaccion(indice, indice + 1, Vector2(1.0f, .0f));
+                if (fila + 1 < filas)
+                    sistema.agregar_interaccion(indice, indice + columnas, Vector2(.0f, -1.0f));
+                else
+                    sistema.agregar_interaccion(indice, piso, Vector2(.0f, -1.0f));
+            }
+    }
+
+    // Cada columna queda como una pila separada sobre el mismo piso
+    void conectar_columnas(Sistema &sistema)
+    {
+        int piso = filas * columnas;
+        for (int fila = 0; fila < filas; fila++)
+            for (int columna = 0; columna < columnas; columna++)
+            {
+                int indice = fila * columnas + columna;
+                int abajo = (fila + 1 < filas) ? indice + columnas : piso;
+                sistema.agregar_interaccion(indice, abajo, Vector2(.0f, -1.0f));
+            }
+    }
+
+    void aplicar_peso(Sistema &sistema)
+    {
+        for (int i = 0; i < filas * columnas; i++)
+            sistema.aplicar_fuerza(particulas[i], Vector2(.0f, -10.0f));
+    }
+};
+
+static void BM_Pila_serial(benchmark::State &state)
+{
+    Pila pila(state.range(0), state.range(0) / 2);
+    Sistema sistema(pila.particulas, .01f);
+    sistema.usar_modo(ModoDelSolver::Serial);
+    pila.conectar(sistema);
+
+    for (auto _ : state)
+    {
+        pila.aplicar_peso(sistema);
+        sistema.expandir_interacciones();
+    }
+    state.SetItemsProcessed(state.iterations() * pila.particulas.size());
+}
+BENCHMARK(BM_Pila_serial)->Arg(128)->Arg(512)->Unit(benchmark::kMillisecond);
+
+// Arg 0: filas de la pila, arg 1: cantidad de hilos
+static void BM_Pila_coloreada(benchmark::State &state)
+{
+    omp_set_num_threads(state.range(1));
+
+    Pila pila(state.range(0), state.range(0) / 2);
+    Sistema sistema(pila.particulas, .01f);
+    sistema.usar_modo(ModoDelSolver::Coloreado);
+    pila.conectar(sistema);
+
+    for (auto _ : state)
+    {
+        pila.aplicar_peso(sistema);
+        sistema.expandir_interacciones();
+    }
+    state.SetItemsProcessed(state.iterations() * pila.particulas.size());
+    state.counters["hilos"] = state.range(1);
+}
+BENCHMARK(BM_Pila_coloreada)->ArgsProduct({{128, 512}, {1, 2, 4, 8}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Arg 0: modo del solver, arg 1: cantidad de hilos
+static void BM_Pilas_separadas(benchmark::State &state)
+{
+    omp_set_num_threads(state.range(1));
+
+    Pila pila(64, 256);
+    Sistema sistema(pila.particulas, .01f);
+    sistema.usar_modo((ModoDelSolver)state.range(0));
+    pila.conectar_columnas(sistema);
+
+    for (auto _ : state)
+    {
+        pila.aplicar_peso(sistema);
+        sistema.expandir_interacciones();
+    }
+    state.SetItemsProcessed(state.iterations() * pila.particulas.size());
+    state.counters["hilos"] = state.range(1);
+}
+BENCHMARK(BM_Pilas_separadas)
+    ->ArgsProduct({{(int)ModoDelSolver::Serial, (int)ModoDelSolver::Islas}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Cumulo denso: todas las particulas se tocan entre si, arg 0 es el tamano.
+// Es donde mas pesa marcar que aristas ya tuvieron interaccion en la iteracion
+static void BM_Cumulo_denso(benchmark::State &state)
+{
+    int cantidad = state.range(0);
+    Pila pila(cantidad, 1);
+    Sistema sistema(pila.particulas, .01f);
+    sistema.usar_modo(ModoDelSolver::Serial);
+
+    for (int i = 0; i < cantidad; i++)
+        for (int j = i + 1; j < cantidad; j++)
+            sistema.agregar_interaccion(i, j, Vector2((float)(j - i), -1.0f).normal());
+
+    for (auto _ : state)
+    {
+        pila.aplicar_peso(sistema);
+        sistema.expandir_interacciones();
+    }
+    state.SetItemsProcessed(state.iterations() * sistema.grafo().cantidad_aristas());
+}
+BENCHMARK(BM_Cumulo_denso)->Arg(16)->Arg(64)->Arg(256);
+
+// Arg 0: modo del solver, arg 1: altura de la pila, que empieza quieta. Se
+// reporta la cantidad de pasadas que uso el ultimo paso
+static void BM_Pila_alta(benchmark::State &state)
+{
+    Pila pila(state.range(1), 32, true);
+    Sistema sistema(pila.particulas, .01f);
+    sistema.usar_modo((ModoDelSolver)state.range(0));
+    sistema.configurar_sueno(.0f, 0);
+    pila.conectar(sistema);
+
+    for (auto _ : state)
+    {
+        pila.aplicar_peso(sistema);
+        sistema.expandir_interacciones();
+    }
+    state.SetItemsProcessed(state.iterations() * pila.particulas.size());
+    state.counters["pasadas"] = sistema.estadisticas().pasadas;
+}
+BENCHMARK(BM_Pila_alta)
+    ->ArgsProduct({{(int)ModoDelSolver::Serial, (int)ModoDelSolver::Ordenado}, {16, 64, 256}})
+    ->Unit(benchmark::kMillisecond);
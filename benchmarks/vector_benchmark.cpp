@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../src/vector.h"
+
+// Los mismos vectores guardados de las dos formas, uno al lado del otro o
+// con cada componente en su arreglo
+struct Vectores
+{
+    std::vector<Vector2> vectores, direcciones;
+    Vector2Batch lote, lote_direcciones;
+
+    Vectores(int cantidad)
+    {
+        for (int i = 0; i < cantidad; i++)
+        {
+            Vector2 vector(.5f * (i % 101) - 25.0f, .25f * (i % 37) + 1.0f);
+            Vector2 direccion(1.0f + i % 7, .5f * (i % 13) - 3.0f);
+            vectores.push_back(vector);
+            direcciones.push_back(direccion);
+            lote.agregar(vector);
+            lote_direcciones.agregar(direccion);
+        }
+    }
+};
+
+static void BM_Vector_suma_escalada(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < datos.vectores.size(); i++)
+            datos.vectores[i] = (datos.vectores[i] + datos.direcciones[i]) * .5f;
+        benchmark::DoNotOptimize(datos.vectores.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Vector_suma_escalada)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Lote_suma_escalada(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+
+    for (auto _ : state)
+    {
+        datos.lote += datos.lote_direcciones;
+        datos.lote *= .5f;
+        benchmark::DoNotOptimize(datos.lote.m_x.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Lote_suma_escalada)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Vector_producto_escalar(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+    std::vector<float> productos(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < datos.vectores.size(); i++)
+            productos[i] = datos.vectores[i] * datos.direcciones[i];
+        benchmark::DoNotOptimize(productos.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Vector_producto_escalar)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Lote_producto_escalar(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+    std::vector<float> productos(state.range(0));
+
+    for (auto _ : state)
+    {
+        datos.lote.producto_escalar(datos.lote_direcciones, productos.data());
+        benchmark::DoNotOptimize(productos.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Lote_producto_escalar)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Vector_proyeccion(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+    std::vector<Vector2> proyectados(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < datos.vectores.size(); i++)
+            proyectados[i] = datos.vectores[i].proyeccion(datos.direcciones[i]);
+        benchmark::DoNotOptimize(proyectados.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Vector_proyeccion)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Lote_proyeccion(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+    Vector2Batch proyectados;
+
+    for (auto _ : state)
+    {
+        datos.lote.proyeccion(datos.lote_direcciones, proyectados);
+        benchmark::DoNotOptimize(proyectados.m_x.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Lote_proyeccion)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Se normalizan las direcciones, que no cambian al volver a normalizarlas
+static void BM_Vector_normal(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (Vector2 &direccion : datos.direcciones)
+            direccion = direccion.normal();
+        benchmark::DoNotOptimize(datos.direcciones.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Vector_normal)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Lote_normalizar(benchmark::State &state)
+{
+    Vectores datos(state.range(0));
+
+    for (auto _ : state)
+    {
+        datos.lote_direcciones.normalizar();
+        benchmark::DoNotOptimize(datos.lote_direcciones.m_x.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Lote_normalizar)->Arg(100000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,91 @@
+#include "arenaDeCuadro.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+ArenaDeCuadro::ArenaDeCuadro(size_t capacidad)
+    : m_buffer(new std::byte[capacidad]), m_capacidad(capacidad), m_usado(0), m_desbordado(0), m_maximo(0),
+      m_bloques(nullptr)
+{
+}
+
+ArenaDeCuadro::~ArenaDeCuadro()
+{
+    liberar_bloques();
+}
+
+void ArenaDeCuadro::reiniciar()
+{
+    if (m_desbordado > 0)
+    {
+        liberar_bloques();
+        m_capacidad = std::max(2 * m_capacidad, m_usado + m_desbordado);
+        m_buffer.reset(new std::byte[m_capacidad]);
+    }
+
+    m_usado = 0;
+    m_desbordado = 0;
+}
+
+size_t ArenaDeCuadro::capacidad() const
+{
+    return m_capacidad;
+}
+
+size_t ArenaDeCuadro::usado() const
+{
+    return m_usado + m_desbordado;
+}
+
+size_t ArenaDeCuadro::maximo() const
+{
+    return m_maximo;
+}
+
+void *ArenaDeCuadro::do_allocate(size_t bytes, size_t alineacion)
+{
+    // Se alinea la direccion y no el desplazamiento, porque el buffer solo
+    // garantiza la alineacion de new
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+    size_t inicio = ((base + m_usado + alineacion - 1) & ~(std::uintptr_t)(alineacion - 1)) - base;
+    if (m_desbordado == 0 && inicio + bytes <= m_capacidad)
+    {
+        m_usado = inicio + bytes;
+        m_maximo = std::max(m_maximo, usado());
+        return m_buffer.get() + inicio;
+    }
+
+    // El bloque lleva adelante el puntero al siguiente, y despues el espacio
+    // pedido alineado
+    size_t encabezado = std::max(sizeof(Bloque), alineacion);
+    std::byte *memoria = static_cast<std::byte *>(::operator new(encabezado + bytes, std::align_val_t(alineacion)));
+
+    Bloque *bloque = reinterpret_cast<Bloque *>(memoria);
+    bloque->siguiente = m_bloques;
+    bloque->alineacion = alineacion;
+    m_bloques = bloque;
+
+    m_desbordado += bytes + alineacion;
+    m_maximo = std::max(m_maximo, usado());
+    return memoria + encabezado;
+}
+
+void ArenaDeCuadro::do_deallocate(void *, size_t, size_t)
+{
+}
+
+bool ArenaDeCuadro::do_is_equal(const std::pmr::memory_resource &otro) const noexcept
+{
+    return this == &otro;
+}
+
+void ArenaDeCuadro::liberar_bloques()
+{
+    while (m_bloques != nullptr)
+    {
+        Bloque *siguiente = m_bloques->siguiente;
+        ::operator delete(m_bloques, std::align_val_t(m_bloques->alineacion));
+        m_bloques = siguiente;
+    }
+}
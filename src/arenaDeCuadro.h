@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// Memoria para los datos temporales de un cuadro. Pedir memoria solo mueve un
+// puntero, liberar no hace nada, y al reiniciar se descarta todo lo del cuadro.
+// Si un cuadro no entra en el buffer, el resto se pide al heap y en el proximo
+// reinicio el buffer crece, por lo que una vez estable no vuelve a pedir memoria
+class ArenaDeCuadro : public std::pmr::memory_resource
+{
+private:
+    struct Bloque
+    {
+        Bloque *siguiente;
+        size_t alineacion;
+    };
+
+    std::unique_ptr<std::byte[]> m_buffer;
+    size_t m_capacidad;
+    size_t m_usado;
+    size_t m_desbordado;
+    size_t m_maximo;
+    Bloque *m_bloques;
+
+public:
+    explicit ArenaDeCuadro(size_t capacidad = 64 * 1024);
+    ~ArenaDeCuadro();
+
+    ArenaDeCuadro(const ArenaDeCuadro &) = delete;
+    ArenaDeCuadro &operator=(const ArenaDeCuadro &) = delete;
+
+    void reiniciar();
+
+    size_t capacidad() const;
+    size_t usado() const;
+    size_t maximo() const; // lo maximo usado en un cuadro
+
+private:
+    void *do_allocate(size_t bytes, size_t alineacion) override;
+    void do_deallocate(void *puntero, size_t bytes, size_t alineacion) override;
+    bool do_is_equal(const std::pmr::memory_resource &otro) const noexcept override;
+
+    void liberar_bloques();
+};
@@ -25,6 +25,31 @@ PuntoDeColision AABB::colisiona(AABB *aabb)
     return colision::colision_aabb_aabb(this, aabb);
 }
 
+bool AABB::intersecta(CuerpoRigido *cuerpo_rigido)
+{
+    return cuerpo_rigido->intersecta(this);
+}
+
+bool AABB::intersecta(Circulo *circulo)
+{
+    return colision::interseccion_circulo_aabb(circulo, this);
+}
+
+bool AABB::intersecta(Linea *linea)
+{
+    return colision::interseccion_aabb_linea(this, linea);
+}
+
+bool AABB::intersecta(AABB *aabb)
+{
+    return colision::interseccion_aabb_aabb(this, aabb);
+}
+
+AABB AABB::limites()
+{
+    return *this;
+}
+
 Vector2 AABB::punto_borde(Vector2 &direccion)
 {
     direccion.x += (direccion.x == .0f) ? .01f : .0f;
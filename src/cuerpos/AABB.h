@@ -15,5 +15,12 @@ public:
     PuntoDeColision colisiona(Linea *linea);
     PuntoDeColision colisiona(AABB *aabb);
 
+    bool intersecta(CuerpoRigido *cuerpo_rigido);
+    bool intersecta(Circulo *circulo);
+    bool intersecta(Linea *linea);
+    bool intersecta(AABB *aabb);
+
+    AABB limites();
+
     Vector2 punto_borde(Vector2 &direccion);
 };
\ No newline at end of file
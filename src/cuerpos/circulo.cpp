@@ -23,4 +23,29 @@ PuntoDeColision Circulo::colisiona(Linea *linea)
 PuntoDeColision Circulo::colisiona(AABB *aabb)
 {
     return colision::colision_circulo_aabb(this, aabb);
-}
\ No newline at end of file
+}
+
+bool Circulo::intersecta(CuerpoRigido *cuerpo_rigido)
+{
+    return cuerpo_rigido->intersecta(this);
+}
+
+bool Circulo::intersecta(Circulo *circulo)
+{
+    return colision::interseccion_circulo_circulo(this, circulo);
+}
+
+bool Circulo::intersecta(Linea *linea)
+{
+    return colision::interseccion_circulo_linea(this, linea);
+}
+
+bool Circulo::intersecta(AABB *aabb)
+{
+    return colision::interseccion_circulo_aabb(this, aabb);
+}
+
+AABB Circulo::limites()
+{
+    return AABB(m_posicion, m_radio, m_radio);
+}
@@ -14,4 +14,11 @@ public:
     PuntoDeColision colisiona(Circulo *circulo);
     PuntoDeColision colisiona(Linea *linea);
     PuntoDeColision colisiona(AABB *aabb);
+
+    bool intersecta(CuerpoRigido *cuerpo_rigido);
+    bool intersecta(Circulo *circulo);
+    bool intersecta(Linea *linea);
+    bool intersecta(AABB *aabb);
+
+    AABB limites();
 };
@@ -4,8 +4,9 @@ namespace colision
 {
     PuntoDeColision colision_circulo_circulo(Circulo *prin, Circulo *secun)
     {
-        Vector2 A = (secun->m_posicion - prin->m_posicion).normal() * prin->m_radio;
-        Vector2 B = (prin->m_posicion - secun->m_posicion).normal() * secun->m_radio;
+        Vector2 direccion = (secun->m_posicion - prin->m_posicion).normal();
+        Vector2 A = prin->m_posicion + direccion * prin->m_radio;
+        Vector2 B = secun->m_posicion - direccion * secun->m_radio;
         bool colisionan = prin->m_radio + secun->m_radio >= (prin->m_posicion - secun->m_posicion).modulo();
 
         return {A, B, (B - A).normal(), (B - A).modulo(), colisionan};
@@ -19,8 +20,8 @@ namespace colision
         float t = std::max<float>(.0f, std::min<float>(largo, proyeccion)) / largo;
 
         Vector2 B = linea->m_posicion + (linea->m_final - linea->m_posicion) * t;
-        Vector2 A = B.normal() * circulo->m_radio;
-        bool colisionan = circulo->m_radio >= B.modulo();
+        Vector2 A = circulo->m_posicion + (B - circulo->m_posicion).normal() * circulo->m_radio;
+        bool colisionan = circulo->m_radio >= (B - circulo->m_posicion).modulo();
 
         return {A, B, (B - A).normal(), (B - A).modulo(), colisionan};
     }
@@ -56,9 +57,9 @@ namespace colision
     {
         Vector2 dir(linea->m_final - linea->m_posicion);
         Vector2 t_cerca(((aabb->m_posicion.x - aabb->m_ancho) - linea->m_posicion.x) / dir.x,
-                        ((aabb->m_posicion.y - aabb->m_ancho) - linea->m_posicion.y) / dir.y);
+                        ((aabb->m_posicion.y - aabb->m_alto) - linea->m_posicion.y) / dir.y);
         Vector2 t_lejos(((aabb->m_posicion.x + aabb->m_ancho) - linea->m_posicion.x) / dir.x,
-                        ((aabb->m_posicion.y - aabb->m_ancho) - linea->m_posicion.y) / dir.y);
+                        ((aabb->m_posicion.y + aabb->m_alto) - linea->m_posicion.y) / dir.y);
 
         if (t_cerca.x > t_lejos.x)
             std::swap(t_cerca.x, t_lejos.x);
@@ -73,8 +74,8 @@ namespace colision
         Vector2 A = linea->m_posicion + dir * t_cerca_colision;
         Vector2 B = linea->m_posicion + dir * t_lejos_colision;
 
-        colisionan = (colisionan) ? !(t_lejos_colision < 0) : colisionan;
+        colisionan = (colisionan) ? !(t_lejos_colision < 0 || t_cerca_colision > 1) : colisionan;
 
         return {A, B, (B - A).normal(), (B - A).modulo(), colisionan};
     }
-}
\ No newline at end of file
+}
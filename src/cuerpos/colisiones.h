@@ -4,6 +4,9 @@
 #include "linea.h"
 #include "circulo.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace colision
 {
     PuntoDeColision colision_circulo_circulo(Circulo *, Circulo *);
@@ -17,4 +20,89 @@ namespace colision
     PuntoDeColision colision_circulo_aabb(Circulo *, AABB *);
 
     PuntoDeColision colision_aabb_linea(AABB *, Linea *);
-}
\ No newline at end of file
+
+    // Lo mismo pero solo si se superponen, sin raices. Que apenas se toquen
+    // tambien cuenta, igual que en los limites del quadtree. Estan en el header
+    // para que se puedan inlinear en los bucles de la fase angosta
+    inline bool interseccion_circulo_circulo(Circulo *prin, Circulo *secun)
+    {
+        float dx = secun->m_posicion.x - prin->m_posicion.x;
+        float dy = secun->m_posicion.y - prin->m_posicion.y;
+        float radios = prin->m_radio + secun->m_radio;
+        return dx * dx + dy * dy <= radios * radios;
+    }
+
+    // El punto del segmento mas cercano al centro, con el segmento de largo
+    // nulo tomado como un punto
+    inline bool interseccion_circulo_linea(Circulo *circulo, Linea *linea)
+    {
+        float dx = linea->m_final.x - linea->m_posicion.x;
+        float dy = linea->m_final.y - linea->m_posicion.y;
+        float cx = circulo->m_posicion.x - linea->m_posicion.x;
+        float cy = circulo->m_posicion.y - linea->m_posicion.y;
+
+        float largo = dx * dx + dy * dy;
+        float t = largo > .0f ? std::clamp((dx * cx + dy * cy) / largo, .0f, 1.0f) : .0f;
+        float x = cx - dx * t, y = cy - dy * t;
+        return x * x + y * y <= circulo->m_radio * circulo->m_radio;
+    }
+
+    // Cada segmento deja los extremos del otro de lados opuestos. Si un extremo
+    // queda sobre la recta del otro, se cortan si ademas cae dentro del
+    // segmento, lo que cubre las T y los segmentos alineados que se superponen
+    inline bool interseccion_linea_linea(Linea *prin, Linea *secun)
+    {
+        auto lado = [](Vector2 a, Vector2 b, Vector2 p)
+        {
+            return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        };
+        auto opuestos = [](float a, float b)
+        {
+            return (a < .0f && b > .0f) || (a > .0f && b < .0f);
+        };
+        auto adentro = [](Vector2 a, Vector2 b, Vector2 p)
+        {
+            return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+                   std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+        };
+
+        Vector2 a = prin->m_posicion, b = prin->m_final;
+        Vector2 c = secun->m_posicion, d = secun->m_final;
+        float lado_c = lado(a, b, c), lado_d = lado(a, b, d);
+        float lado_a = lado(c, d, a), lado_b = lado(c, d, b);
+
+        if (opuestos(lado_c, lado_d) && opuestos(lado_a, lado_b))
+            return true;
+
+        return (lado_c == .0f && adentro(a, b, c)) || (lado_d == .0f && adentro(a, b, d)) ||
+               (lado_a == .0f && adentro(c, d, a)) || (lado_b == .0f && adentro(c, d, b));
+    }
+
+    inline bool interseccion_aabb_aabb(AABB *prin, AABB *secun)
+    {
+        return std::abs(secun->m_posicion.x - prin->m_posicion.x) <= prin->m_ancho + secun->m_ancho &&
+               std::abs(secun->m_posicion.y - prin->m_posicion.y) <= prin->m_alto + secun->m_alto;
+    }
+
+    // La distancia del centro al punto mas cercano de la caja
+    inline bool interseccion_circulo_aabb(Circulo *circulo, AABB *aabb)
+    {
+        float x = std::max(std::abs(circulo->m_posicion.x - aabb->m_posicion.x) - aabb->m_ancho, .0f);
+        float y = std::max(std::abs(circulo->m_posicion.y - aabb->m_posicion.y) - aabb->m_alto, .0f);
+        return x * x + y * y <= circulo->m_radio * circulo->m_radio;
+    }
+
+    // Ejes separadores: los dos de la caja, y la normal del segmento, desde el
+    // medio del segmento. Sin divisiones, por lo que no le afectan los
+    // segmentos paralelos a los ejes
+    inline bool interseccion_aabb_linea(AABB *aabb, Linea *linea)
+    {
+        float mitad_x = (linea->m_final.x - linea->m_posicion.x) * .5f;
+        float mitad_y = (linea->m_final.y - linea->m_posicion.y) * .5f;
+        float dx = linea->m_posicion.x + mitad_x - aabb->m_posicion.x;
+        float dy = linea->m_posicion.y + mitad_y - aabb->m_posicion.y;
+
+        return std::abs(dx) <= aabb->m_ancho + std::abs(mitad_x) && std::abs(dy) <= aabb->m_alto + std::abs(mitad_y) &&
+               std::abs(mitad_x * dy - mitad_y * dx) <= aabb->m_ancho * std::abs(mitad_y) + aabb->m_alto * std::abs(mitad_x);
+    }
+}
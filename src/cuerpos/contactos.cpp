@@ -0,0 +1,177 @@
+#include "contactos.h"
+
+#include <cmath>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CONTACTOS_X86
+#include <immintrin.h>
+#endif
+
+namespace colision
+{
+    void ParesDeCirculos::agregar(const Circulo &a, const Circulo &b)
+    {
+        a_x.push_back(a.m_posicion.x);
+        a_y.push_back(a.m_posicion.y);
+        a_radio.push_back(a.m_radio);
+        b_x.push_back(b.m_posicion.x);
+        b_y.push_back(b.m_posicion.y);
+        b_radio.push_back(b.m_radio);
+    }
+
+    void ParesDeCirculos::reservar(int cantidad)
+    {
+        for (auto *arreglo : {&a_x, &a_y, &a_radio, &b_x, &b_y, &b_radio})
+            arreglo->reserve(cantidad);
+    }
+
+    void ParesDeCirculos::vaciar()
+    {
+        for (auto *arreglo : {&a_x, &a_y, &a_radio, &b_x, &b_y, &b_radio})
+            arreglo->clear();
+    }
+
+    int ParesDeCirculos::cantidad() const
+    {
+        return (int)a_x.size();
+    }
+
+    // Los punteros de los arreglos, para que cada version recorra desde un indice
+    struct Arreglos
+    {
+        const float *a_x, *a_y, *a_radio;
+        const float *b_x, *b_y, *b_radio;
+        float *penetracion, *normal_x, *normal_y;
+        uint8_t *colisiono;
+    };
+
+    // La normal va de A hacia B, los puntos de cada borde sobre la recta entre
+    // los centros, por lo que cambia de sentido segun si se superponen o no
+    static void escalar(Arreglos &arreglos, int desde, int hasta)
+    {
+        for (int i = desde; i < hasta; i++)
+        {
+            float dx = arreglos.b_x[i] - arreglos.a_x[i];
+            float dy = arreglos.b_y[i] - arreglos.a_y[i];
+            float distancia = std::sqrt(dx * dx + dy * dy);
+            float penetracion = arreglos.a_radio[i] + arreglos.b_radio[i] - distancia;
+
+            float inversa = distancia > .0f ? 1.0f / distancia : .0f;
+            float signo = penetracion > .0f ? -1.0f : (penetracion < .0f ? 1.0f : .0f);
+
+            arreglos.penetracion[i] = penetracion;
+            arreglos.normal_x[i] = dx * inversa * signo;
+            arreglos.normal_y[i] = dy * inversa * signo;
+            arreglos.colisiono[i] = penetracion >= .0f;
+        }
+    }
+
+#ifdef CONTACTOS_X86
+    // Las mismas cuentas que escalar, de a 4 pares. Con raiz y division
+    // exactas, no las aproximadas, para dar lo mismo que la version escalar
+    static int sse(Arreglos &arreglos, int cantidad)
+    {
+        const __m128 cero = _mm_setzero_ps(), uno = _mm_set1_ps(1.0f);
+
+        int i = 0;
+        for (; i + 4 <= cantidad; i += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(arreglos.b_x + i), _mm_loadu_ps(arreglos.a_x + i));
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(arreglos.b_y + i), _mm_loadu_ps(arreglos.a_y + i));
+            __m128 distancia = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+            __m128 radios = _mm_add_ps(_mm_loadu_ps(arreglos.a_radio + i), _mm_loadu_ps(arreglos.b_radio + i));
+            __m128 penetracion = _mm_sub_ps(radios, distancia);
+
+            __m128 inversa = _mm_and_ps(_mm_div_ps(uno, distancia), _mm_cmpgt_ps(distancia, cero));
+            __m128 signo = _mm_sub_ps(_mm_and_ps(_mm_cmplt_ps(penetracion, cero), uno),
+                                      _mm_and_ps(_mm_cmpgt_ps(penetracion, cero), uno));
+            __m128 escala = _mm_mul_ps(inversa, signo);
+
+            _mm_storeu_ps(arreglos.penetracion + i, penetracion);
+            _mm_storeu_ps(arreglos.normal_x + i, _mm_mul_ps(dx, escala));
+            _mm_storeu_ps(arreglos.normal_y + i, _mm_mul_ps(dy, escala));
+
+            int mascara = _mm_movemask_ps(_mm_cmpge_ps(penetracion, cero));
+            for (int j = 0; j < 4; j++)
+                arreglos.colisiono[i + j] = (mascara >> j) & 1;
+        }
+        return i;
+    }
+
+    // De a 8 pares. Sin fma, que redondea distinto a la version escalar
+    __attribute__((target("avx2"))) static int avx2(Arreglos &arreglos, int cantidad)
+    {
+        const __m256 cero = _mm256_setzero_ps(), uno = _mm256_set1_ps(1.0f);
+
+        int i = 0;
+        for (; i + 8 <= cantidad; i += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(arreglos.b_x + i), _mm256_loadu_ps(arreglos.a_x + i));
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(arreglos.b_y + i), _mm256_loadu_ps(arreglos.a_y + i));
+            __m256 distancia = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+            __m256 radios = _mm256_add_ps(_mm256_loadu_ps(arreglos.a_radio + i), _mm256_loadu_ps(arreglos.b_radio + i));
+            __m256 penetracion = _mm256_sub_ps(radios, distancia);
+
+            __m256 inversa = _mm256_and_ps(_mm256_div_ps(uno, distancia), _mm256_cmp_ps(distancia, cero, _CMP_GT_OQ));
+            __m256 signo = _mm256_sub_ps(_mm256_and_ps(_mm256_cmp_ps(penetracion, cero, _CMP_LT_OQ), uno),
+                                         _mm256_and_ps(_mm256_cmp_ps(penetracion, cero, _CMP_GT_OQ), uno));
+            __m256 escala = _mm256_mul_ps(inversa, signo);
+
+            _mm256_storeu_ps(arreglos.penetracion + i, penetracion);
+            _mm256_storeu_ps(arreglos.normal_x + i, _mm256_mul_ps(dx, escala));
+            _mm256_storeu_ps(arreglos.normal_y + i, _mm256_mul_ps(dy, escala));
+
+            int mascara = _mm256_movemask_ps(_mm256_cmp_ps(penetracion, cero, _CMP_GE_OQ));
+            for (int j = 0; j < 8; j++)
+                arreglos.colisiono[i + j] = (mascara >> j) & 1;
+        }
+        return i;
+    }
+#endif
+
+    Instrucciones instrucciones_disponibles()
+    {
+#ifdef CONTACTOS_X86
+        static const Instrucciones disponibles = __builtin_cpu_supports("avx2") ? Instrucciones::AVX2
+                                                                                : Instrucciones::SSE;
+        return disponibles;
+#else
+        return Instrucciones::Escalar;
+#endif
+    }
+
+    void colisiones_circulo_circulo(const ParesDeCirculos &pares, ContactosDeCirculos &contactos)
+    {
+        colisiones_circulo_circulo(pares, contactos, instrucciones_disponibles());
+    }
+
+    void colisiones_circulo_circulo(const ParesDeCirculos &pares, ContactosDeCirculos &contactos,
+                                    Instrucciones instrucciones)
+    {
+        int cantidad = pares.cantidad();
+        contactos.penetracion.resize(cantidad);
+        contactos.normal_x.resize(cantidad);
+        contactos.normal_y.resize(cantidad);
+        contactos.colisiono.resize(cantidad);
+
+        Arreglos arreglos = {
+            pares.a_x.data(), pares.a_y.data(), pares.a_radio.data(),
+            pares.b_x.data(), pares.b_y.data(), pares.b_radio.data(),
+            contactos.penetracion.data(), contactos.normal_x.data(), contactos.normal_y.data(),
+            contactos.colisiono.data()};
+
+        if (instrucciones > instrucciones_disponibles())
+            instrucciones = instrucciones_disponibles();
+
+        // Las versiones vectoriales dejan el resto, que no llena un registro,
+        // para la escalar
+        int hechos = 0;
+#ifdef CONTACTOS_X86
+        if (instrucciones == Instrucciones::AVX2)
+            hechos = avx2(arreglos, cantidad);
+        else if (instrucciones == Instrucciones::SSE)
+            hechos = sse(arreglos, cantidad);
+#endif
+        escalar(arreglos, hechos, cantidad);
+    }
+}
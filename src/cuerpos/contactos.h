@@ -0,0 +1,50 @@
+#pragma once
+
+#include "circulo.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace colision
+{
+    // Pares candidatos entre circulos, con cada campo en su propio arreglo
+    // (structure of arrays) para poder cargar varios pares en un registro
+    struct ParesDeCirculos
+    {
+        std::vector<float> a_x, a_y, a_radio;
+        std::vector<float> b_x, b_y, b_radio;
+
+        void agregar(const Circulo &a, const Circulo &b);
+        void reservar(int cantidad);
+        void vaciar();
+        int cantidad() const;
+    };
+
+    // El resultado de cada par en el mismo orden. La penetracion es la suma de
+    // los radios menos la distancia entre los centros, y la normal es la del
+    // PuntoDeColision de colision_circulo_circulo
+    struct ContactosDeCirculos
+    {
+        std::vector<float> penetracion;
+        std::vector<float> normal_x, normal_y;
+        std::vector<uint8_t> colisiono;
+    };
+
+    enum class Instrucciones
+    {
+        Escalar,
+        SSE,
+        AVX2,
+    };
+
+    // Las mejores que soporta el procesador, averiguado una sola vez
+    Instrucciones instrucciones_disponibles();
+
+    // Prueba todos los pares a la vez, con las mejores instrucciones disponibles
+    void colisiones_circulo_circulo(const ParesDeCirculos &pares, ContactosDeCirculos &contactos);
+
+    // Con unas instrucciones en particular, que si el procesador no las
+    // soporta se cambian por las disponibles
+    void colisiones_circulo_circulo(const ParesDeCirculos &pares, ContactosDeCirculos &contactos,
+                                    Instrucciones instrucciones);
+}
@@ -31,9 +31,19 @@ public:
 
 public:
     CuerpoRigido(Vector2 posicion) : m_posicion(posicion) {}
+    virtual ~CuerpoRigido() = default;
 
     virtual PuntoDeColision colisiona(CuerpoRigido *cuerpo_rigido) = 0;
     virtual PuntoDeColision colisiona(Circulo *circulo) = 0;
     virtual PuntoDeColision colisiona(Linea *linea) = 0;
     virtual PuntoDeColision colisiona(AABB *aabb) = 0;
+
+    // Solo si se superponen, sin calcular el punto de colision y sin raices.
+    // Es lo que alcanza para descartar, y colisiona queda para resolver
+    virtual bool intersecta(CuerpoRigido *cuerpo_rigido) = 0;
+    virtual bool intersecta(Circulo *circulo) = 0;
+    virtual bool intersecta(Linea *linea) = 0;
+    virtual bool intersecta(AABB *aabb) = 0;
+
+    virtual AABB limites() = 0; // la menor caja alineada a los ejes que lo contiene
 };
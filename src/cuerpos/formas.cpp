@@ -0,0 +1,77 @@
+#include "formas.h"
+
+IdDeForma Formas::agregar(const Forma &forma)
+{
+    return std::visit(
+        [this](const auto &valor)
+        {
+            using Tipo = std::decay_t<decltype(valor)>;
+            constexpr uint32_t tipo = std::is_same_v<Tipo, Circulo> ? 0 : std::is_same_v<Tipo, Linea> ? 1 : 2;
+
+            auto &arreglo = this->arreglo<tipo>();
+            arreglo.emplace_back(valor);
+            return IdDeForma{tipo, (uint32_t)arreglo.size() - 1};
+        },
+        forma);
+}
+
+Forma Formas::forma(IdDeForma id) const
+{
+    switch (id.tipo)
+    {
+    case 0:
+        return m_circulos[id.indice];
+    case 1:
+        return m_lineas[id.indice];
+    default:
+        return m_aabbs[id.indice];
+    }
+}
+
+CuerpoRigido *Formas::cuerpo(IdDeForma id)
+{
+    switch (id.tipo)
+    {
+    case 0:
+        return &m_circulos[id.indice];
+    case 1:
+        return &m_lineas[id.indice];
+    default:
+        return &m_aabbs[id.indice];
+    }
+}
+
+int Formas::cantidad() const
+{
+    return (int)(m_circulos.size() + m_lineas.size() + m_aabbs.size());
+}
+
+void Formas::vaciar()
+{
+    m_circulos.clear();
+    m_lineas.clear();
+    m_aabbs.clear();
+}
+
+// Se guarda con el tipo de menor indice primero, asi cada grupo tiene una
+// sola funcion
+void LoteDePares::agregar(IdDeForma a, IdDeForma b)
+{
+    if (a.tipo > b.tipo)
+        std::swap(a, b);
+    m_grupos[a.tipo * colision::tipos_de_forma + b.tipo].emplace_back(a.indice, b.indice);
+}
+
+int LoteDePares::cantidad() const
+{
+    int cantidad = 0;
+    for (const auto &grupo : m_grupos)
+        cantidad += (int)grupo.size();
+    return cantidad;
+}
+
+void LoteDePares::vaciar()
+{
+    for (auto &grupo : m_grupos)
+        grupo.clear();
+}
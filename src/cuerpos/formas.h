@@ -0,0 +1,195 @@
+#pragma once
+
+#include "colisiones.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Un cuerpo por valor, donde el tipo lo guarda la variante y no la tabla
+// virtual. El orden de los tipos es el de las filas y columnas de las tablas
+using Forma = std::variant<Circulo, Linea, AABB>;
+
+namespace colision
+{
+    constexpr int tipos_de_forma = (int)std::variant_size_v<Forma>;
+
+    // Una funcion por par de tipos, con el de menor indice primero. Son las
+    // mismas funciones que usan los cuerpos, con los argumentos ordenados
+    inline PuntoDeColision colision(Circulo &a, Circulo &b) { return colision_circulo_circulo(&a, &b); }
+    inline PuntoDeColision colision(Circulo &a, Linea &b) { return colision_circulo_linea(&a, &b); }
+    inline PuntoDeColision colision(Circulo &a, AABB &b) { return colision_circulo_aabb(&a, &b); }
+    inline PuntoDeColision colision(Linea &a, Linea &b) { return colision_linea_linea(&a, &b); }
+    inline PuntoDeColision colision(Linea &a, AABB &b) { return colision_aabb_linea(&b, &a).invertir(); }
+    inline PuntoDeColision colision(AABB &a, AABB &b) { return colision_aabb_aabb(&a, &b); }
+
+    inline bool interseccion(Circulo &a, Circulo &b) { return interseccion_circulo_circulo(&a, &b); }
+    inline bool interseccion(Circulo &a, Linea &b) { return interseccion_circulo_linea(&a, &b); }
+    inline bool interseccion(Circulo &a, AABB &b) { return interseccion_circulo_aabb(&a, &b); }
+    inline bool interseccion(Linea &a, Linea &b) { return interseccion_linea_linea(&a, &b); }
+    inline bool interseccion(Linea &a, AABB &b) { return interseccion_aabb_linea(&b, &a); }
+    inline bool interseccion(AABB &a, AABB &b) { return interseccion_aabb_aabb(&a, &b); }
+
+    template <int I, int J>
+    PuntoDeColision colision_entre(Forma &a, Forma &b)
+    {
+        if constexpr (I <= J)
+            return colision(*std::get_if<I>(&a), *std::get_if<J>(&b));
+        else
+            return colision(*std::get_if<J>(&b), *std::get_if<I>(&a)).invertir();
+    }
+
+    template <int I, int J>
+    bool interseccion_entre(Forma &a, Forma &b)
+    {
+        if constexpr (I <= J)
+            return interseccion(*std::get_if<I>(&a), *std::get_if<J>(&b));
+        else
+            return interseccion(*std::get_if<J>(&b), *std::get_if<I>(&a));
+    }
+
+    using FuncionDeColision = PuntoDeColision (*)(Forma &, Forma &);
+    using FuncionDeInterseccion = bool (*)(Forma &, Forma &);
+
+    // Tablas indexadas por el tipo de cada forma: una sola indireccion por par,
+    // en vez de las dos llamadas virtuales de CuerpoRigido
+    inline constexpr FuncionDeColision tabla_de_colisiones[tipos_de_forma][tipos_de_forma] = {
+        {colision_entre<0, 0>, colision_entre<0, 1>, colision_entre<0, 2>},
+        {colision_entre<1, 0>, colision_entre<1, 1>, colision_entre<1, 2>},
+        {colision_entre<2, 0>, colision_entre<2, 1>, colision_entre<2, 2>},
+    };
+
+    inline constexpr FuncionDeInterseccion tabla_de_intersecciones[tipos_de_forma][tipos_de_forma] = {
+        {interseccion_entre<0, 0>, interseccion_entre<0, 1>, interseccion_entre<0, 2>},
+        {interseccion_entre<1, 0>, interseccion_entre<1, 1>, interseccion_entre<1, 2>},
+        {interseccion_entre<2, 0>, interseccion_entre<2, 1>, interseccion_entre<2, 2>},
+    };
+
+    inline PuntoDeColision colisiona(Forma &a, Forma &b)
+    {
+        return tabla_de_colisiones[a.index()][b.index()](a, b);
+    }
+
+    inline bool intersecta(Forma &a, Forma &b)
+    {
+        return tabla_de_intersecciones[a.index()][b.index()](a, b);
+    }
+}
+
+// Una forma guardada en Formas: su tipo y su posicion en el arreglo de ese tipo
+struct IdDeForma
+{
+    uint32_t tipo;
+    uint32_t indice;
+
+    bool operator==(const IdDeForma &otro) const = default;
+};
+
+// Las formas separadas en un arreglo por tipo, contiguas y sin punteros, para
+// que la fase angosta recorra cada tipo en un bucle
+class Formas
+{
+public:
+    std::vector<Circulo> m_circulos;
+    std::vector<Linea> m_lineas;
+    std::vector<AABB> m_aabbs;
+
+public:
+    IdDeForma agregar(const Forma &forma);
+    Forma forma(IdDeForma id) const;
+    int cantidad() const;
+    void vaciar();
+
+    // Para usar una forma donde se espera la interfaz virtual. El puntero deja
+    // de valer si se agregan formas de su tipo
+    CuerpoRigido *cuerpo(IdDeForma id);
+
+    template <int I>
+    auto &arreglo()
+    {
+        if constexpr (I == 0)
+            return m_circulos;
+        else if constexpr (I == 1)
+            return m_lineas;
+        else
+            return m_aabbs;
+    }
+};
+
+// Fase angosta por lotes: los pares se agrupan por par de tipos, con el de
+// menor indice primero, y cada grupo se prueba con su funcion en un bucle,
+// sin despachar por cada par
+class LoteDePares
+{
+private:
+    std::array<std::vector<std::pair<uint32_t, uint32_t>>, colision::tipos_de_forma * colision::tipos_de_forma>
+        m_grupos;
+
+public:
+    void agregar(IdDeForma a, IdDeForma b);
+    int cantidad() const;
+    void vaciar();
+
+    // Llama a funcion(a, b) con cada par que se superpone
+    template <typename Funcion>
+    void intersecciones(Formas &formas, Funcion &&funcion);
+
+    // Llama a funcion(a, b, punto) con el punto de colision de cada par que
+    // colisiona, con la normal desde a hacia b
+    template <typename Funcion>
+    void colisiones(Formas &formas, Funcion &&funcion);
+
+private:
+    template <int I, int J, typename Funcion>
+    void intersecciones_de(Formas &formas, Funcion &funcion);
+
+    template <int I, int J, typename Funcion>
+    void colisiones_de(Formas &formas, Funcion &funcion);
+};
+
+template <typename Funcion>
+void LoteDePares::intersecciones(Formas &formas, Funcion &&funcion)
+{
+    intersecciones_de<0, 0>(formas, funcion);
+    intersecciones_de<0, 1>(formas, funcion);
+    intersecciones_de<0, 2>(formas, funcion);
+    intersecciones_de<1, 1>(formas, funcion);
+    intersecciones_de<1, 2>(formas, funcion);
+    intersecciones_de<2, 2>(formas, funcion);
+}
+
+template <typename Funcion>
+void LoteDePares::colisiones(Formas &formas, Funcion &&funcion)
+{
+    colisiones_de<0, 0>(formas, funcion);
+    colisiones_de<0, 1>(formas, funcion);
+    colisiones_de<0, 2>(formas, funcion);
+    colisiones_de<1, 1>(formas, funcion);
+    colisiones_de<1, 2>(formas, funcion);
+    colisiones_de<2, 2>(formas, funcion);
+}
+
+template <int I, int J, typename Funcion>
+void LoteDePares::intersecciones_de(Formas &formas, Funcion &funcion)
+{
+    auto &primeras = formas.arreglo<I>();
+    auto &segundas = formas.arreglo<J>();
+    for (auto [a, b] : m_grupos[I * colision::tipos_de_forma + J])
+        if (colision::interseccion(primeras[a], segundas[b]))
+            funcion(IdDeForma{I, a}, IdDeForma{J, b});
+}
+
+template <int I, int J, typename Funcion>
+void LoteDePares::colisiones_de(Formas &formas, Funcion &funcion)
+{
+    auto &primeras = formas.arreglo<I>();
+    auto &segundas = formas.arreglo<J>();
+    for (auto [a, b] : m_grupos[I * colision::tipos_de_forma + J])
+    {
+        PuntoDeColision punto = colision::colision(primeras[a], segundas[b]);
+        if (punto.colisiono)
+            funcion(IdDeForma{I, a}, IdDeForma{J, b}, punto);
+    }
+}
@@ -1,5 +1,7 @@
 #include "colisiones.h"
 
+#include <cmath>
+
 Linea::Linea(Vector2 principio, Vector2 final)
     : CuerpoRigido(principio), m_final(final)
 {
@@ -24,3 +26,29 @@ PuntoDeColision Linea::colisiona(AABB *aabb)
 {
     return colision::colision_aabb_linea(aabb, this).invertir();
 }
+
+bool Linea::intersecta(CuerpoRigido *cuerpo_rigido)
+{
+    return cuerpo_rigido->intersecta(this);
+}
+
+bool Linea::intersecta(Circulo *circulo)
+{
+    return colision::interseccion_circulo_linea(circulo, this);
+}
+
+bool Linea::intersecta(Linea *linea)
+{
+    return colision::interseccion_linea_linea(this, linea);
+}
+
+bool Linea::intersecta(AABB *aabb)
+{
+    return colision::interseccion_aabb_linea(aabb, this);
+}
+
+AABB Linea::limites()
+{
+    Vector2 mitad = (m_final - m_posicion) / 2.0f;
+    return AABB(m_posicion + mitad, std::abs(mitad.x), std::abs(mitad.y));
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <coroutine>
+#include <iterator>
+#include <utility>
+
+// Generador para corrutinas de C++20: cada co_yield entrega un valor y la
+// corrutina queda suspendida hasta que se pide el siguiente, por lo que se
+// puede dejar de recorrer en cualquier momento
+template <typename T>
+class Generador
+{
+public:
+    struct promise_type
+    {
+        T m_valor;
+
+        Generador get_return_object()
+        {
+            return Generador(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { throw; }
+
+        std::suspend_always yield_value(T valor) noexcept
+        {
+            m_valor = valor;
+            return {};
+        }
+    };
+
+    class Iterador
+    {
+    private:
+        std::coroutine_handle<promise_type> m_corrutina;
+
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterador() = default;
+        explicit Iterador(std::coroutine_handle<promise_type> corrutina)
+            : m_corrutina(corrutina)
+        {
+        }
+
+        T operator*() const { return m_corrutina.promise().m_valor; }
+
+        Iterador &operator++()
+        {
+            m_corrutina.resume();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return m_corrutina.done(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_corrutina;
+
+    explicit Generador(std::coroutine_handle<promise_type> corrutina)
+        : m_corrutina(corrutina)
+    {
+    }
+
+public:
+    Generador(Generador &&otro) noexcept
+        : m_corrutina(std::exchange(otro.m_corrutina, nullptr))
+    {
+    }
+
+    Generador &operator=(Generador &&otro) noexcept
+    {
+        std::swap(m_corrutina, otro.m_corrutina);
+        return *this;
+    }
+
+    ~Generador()
+    {
+        if (m_corrutina)
+            m_corrutina.destroy();
+    }
+
+    Iterador begin()
+    {
+        m_corrutina.resume();
+        return Iterador(m_corrutina);
+    }
+
+    std::default_sentinel_t end() { return {}; }
+};
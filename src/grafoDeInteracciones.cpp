@@ -0,0 +1,325 @@
+#include "grafoDeInteracciones.h"
+
+#include <utility>
+#include <algorithm>
+
+using namespace sistema;
+
+Interaccion::Interaccion(int particula, int referencia, Vector2 direccion, float dt)
+    : m_particula(particula), m_referencia(referencia), m_direccion(direccion), m_dt(dt)
+{
+}
+
+GrafoDeInteracciones::GrafoDeInteracciones()
+    : m_construido(false), m_coloreado(false)
+{
+}
+
+void GrafoDeInteracciones::agregar(int particula, int referencia, Vector2 direccion, float dt)
+{
+    if (particula == referencia)
+        return;
+
+    if (particula > referencia)
+    {
+        std::swap(particula, referencia);
+        direccion *= -1.0f;
+    }
+
+    m_lote.emplace_back(particula, referencia, direccion, dt);
+    m_construido = false;
+    m_coloreado = false;
+}
+
+void GrafoDeInteracciones::limpiar()
+{
+    m_lote.clear();
+    m_construido = false;
+    m_coloreado = false;
+}
+
+// Ordenamiento por conteo estable, primero por b y despues por a, dejando el
+// lote ordenado por (a, b) en tiempo lineal
+void GrafoDeInteracciones::ordenar_por(bool por_a, int cantidad_particulas)
+{
+    m_contador.assign(cantidad_particulas + 1, 0);
+    for (const Interaccion &interaccion : m_lote)
+        m_contador[(por_a ? interaccion.m_particula : interaccion.m_referencia) + 1]++;
+    for (int i = 0; i < cantidad_particulas; i++)
+        m_contador[i + 1] += m_contador[i];
+
+    m_auxiliar.resize(m_lote.size(), Interaccion(0, 0, Vector2(), .0f));
+    for (const Interaccion &interaccion : m_lote)
+        m_auxiliar[m_contador[por_a ? interaccion.m_particula : interaccion.m_referencia]++] = interaccion;
+    m_lote.swap(m_auxiliar);
+}
+
+void GrafoDeInteracciones::construir(int cantidad_particulas)
+{
+    ordenar_por(false, cantidad_particulas);
+    ordenar_por(true, cantidad_particulas);
+
+    m_a.clear();
+    m_b.clear();
+    m_direccion_x.clear();
+    m_direccion_y.clear();
+    m_dt.clear();
+
+    for (const Interaccion &interaccion : m_lote)
+    {
+        bool repetida = !m_a.empty() && m_a.back() == interaccion.m_particula && m_b.back() == interaccion.m_referencia;
+        if (repetida)
+            continue;
+
+        m_a.emplace_back(interaccion.m_particula);
+        m_b.emplace_back(interaccion.m_referencia);
+        m_direccion_x.emplace_back(interaccion.m_direccion.x);
+        m_direccion_y.emplace_back(interaccion.m_direccion.y);
+        m_dt.emplace_back(interaccion.m_dt);
+    }
+
+    const int aristas = cantidad_aristas();
+    m_desplazamientos.assign(cantidad_particulas + 1, 0);
+    for (int arista = 0; arista < aristas; arista++)
+    {
+        m_desplazamientos[m_a[arista] + 1]++;
+        m_desplazamientos[m_b[arista] + 1]++;
+    }
+    for (int i = 0; i < cantidad_particulas; i++)
+        m_desplazamientos[i + 1] += m_desplazamientos[i];
+
+    m_contador.assign(m_desplazamientos.begin(), m_desplazamientos.end() - 1);
+    m_incidencias.resize(2 * aristas);
+    for (int arista = 0; arista < aristas; arista++)
+    {
+        m_incidencias[m_contador[m_a[arista]]++] = arista;
+        m_incidencias[m_contador[m_b[arista]]++] = arista;
+    }
+
+    m_visita.assign(aristas, 0);
+
+    m_construido = true;
+    m_coloreado = false;
+}
+
+// Coloreo greedy de aristas, cada arista toma el menor color que no use
+// ninguna otra arista de sus extremos. Los extremos marcados en ignorar (las
+// particulas estaticas, que nunca se escriben) no restringen el color
+void GrafoDeInteracciones::colorear(const std::vector<uint8_t> &ignorar)
+{
+    const int aristas = cantidad_aristas();
+    m_color.assign(aristas, -1);
+
+    std::vector<int> &marca = m_marca;
+    marca.assign(marca.size(), -1);
+    int colores = 0;
+
+    for (int arista = 0; arista < aristas; arista++)
+    {
+        for (int extremo : {m_a[arista], m_b[arista]})
+        {
+            if (ignorar[extremo])
+                continue;
+
+            for (int i = m_desplazamientos[extremo]; i < m_desplazamientos[extremo + 1]; i++)
+            {
+                int color = m_color[m_incidencias[i]];
+                if (color < 0)
+                    continue;
+                if (color >= (int)marca.size())
+                    marca.resize(color + 1, -1);
+                marca[color] = arista;
+            }
+        }
+
+        int color = 0;
+        while (color < (int)marca.size() && marca[color] == arista)
+            color++;
+
+        m_color[arista] = color;
+        colores = std::max(colores, color + 1);
+    }
+
+    m_desplazamientos_color.assign(colores + 1, 0);
+    for (int color : m_color)
+        m_desplazamientos_color[color + 1]++;
+    for (int i = 0; i < colores; i++)
+        m_desplazamientos_color[i + 1] += m_desplazamientos_color[i];
+
+    m_contador.assign(m_desplazamientos_color.begin(), m_desplazamientos_color.end() - 1);
+    m_aristas_por_color.resize(aristas);
+    for (int arista = 0; arista < aristas; arista++)
+        m_aristas_por_color[m_contador[m_color[arista]]++] = arista;
+
+    m_coloreado = true;
+}
+
+int GrafoDeInteracciones::raiz(int particula)
+{
+    while (m_padre[particula] != particula)
+    {
+        m_padre[particula] = m_padre[m_padre[particula]];
+        particula = m_padre[particula];
+    }
+    return particula;
+}
+
+// Union-find sobre las aristas, sin unir a traves de las fronteras (las
+// particulas estaticas que no se mueven), ya que nunca se modifican y se
+// pueden compartir entre islas sin problema
+void GrafoDeInteracciones::separar_en_islas(const std::vector<uint8_t> &fronteras)
+{
+    const int particulas = cantidad_particulas();
+    const int aristas = cantidad_aristas();
+
+    m_padre.resize(particulas);
+    for (int i = 0; i < particulas; i++)
+        m_padre[i] = i;
+
+    for (int arista = 0; arista < aristas; arista++)
+    {
+        int a = m_a[arista], b = m_b[arista];
+        if (fronteras[a] || fronteras[b])
+            continue;
+
+        a = raiz(a);
+        b = raiz(b);
+        if (a != b)
+            m_padre[std::max(a, b)] = std::min(a, b);
+    }
+
+    // Las raices toman un numero de isla, y se cuentan sus particulas
+    m_isla.assign(particulas, -1);
+    m_contador.clear();
+    for (int i = 0; i < particulas; i++)
+    {
+        bool aislada = m_desplazamientos[i] == m_desplazamientos[i + 1];
+        if (fronteras[i] || aislada)
+            continue;
+
+        int r = raiz(i);
+        if (m_isla[r] < 0)
+        {
+            m_isla[r] = (int)m_contador.size();
+            m_contador.emplace_back(0);
+        }
+        m_isla[i] = m_isla[r];
+        m_contador[m_isla[i]]++;
+    }
+
+    const int islas = (int)m_contador.size();
+    m_orden_islas.resize(islas);
+    for (int i = 0; i < islas; i++)
+        m_orden_islas[i] = i;
+    std::sort(m_orden_islas.begin(), m_orden_islas.end(), [this](int a, int b)
+              { return m_contador[a] > m_contador[b]; });
+
+    // m_marca pasa a ser la posicion de cada isla en el orden de mayor a menor
+    m_marca.resize(islas);
+    m_desplazamientos_isla.assign(islas + 1, 0);
+    for (int posicion = 0; posicion < islas; posicion++)
+    {
+        m_marca[m_orden_islas[posicion]] = posicion;
+        m_desplazamientos_isla[posicion + 1] = m_desplazamientos_isla[posicion] + m_contador[m_orden_islas[posicion]];
+    }
+
+    m_contador.assign(m_desplazamientos_isla.begin(), m_desplazamientos_isla.end() - 1);
+    m_particulas_por_isla.resize(m_desplazamientos_isla.back());
+    for (int i = 0; i < particulas; i++)
+    {
+        if (m_isla[i] < 0)
+            continue;
+        m_isla[i] = m_marca[m_isla[i]];
+        m_particulas_por_isla[m_contador[m_isla[i]]++] = i;
+    }
+}
+
+// Recorrido en anchura desde todos los soportes a la vez. Las particulas que
+// no llegan a ningun soporte quedan con la altura maxima, y van primero
+void GrafoDeInteracciones::ordenar_por_soporte(const std::vector<uint8_t> &soportes)
+{
+    const int particulas = cantidad_particulas();
+
+    m_altura.assign(particulas, -1);
+    m_contador.clear();
+    for (int i = 0; i < particulas; i++)
+        if (soportes[i])
+        {
+            m_altura[i] = 0;
+            m_contador.emplace_back(i);
+        }
+
+    int altura_maxima = 0;
+    for (size_t actual = 0; actual < m_contador.size(); actual++)
+    {
+        int particula = m_contador[actual];
+        for (int i = m_desplazamientos[particula]; i < m_desplazamientos[particula + 1]; i++)
+        {
+            int vecina = otra(m_incidencias[i], particula);
+            if (m_altura[vecina] >= 0)
+                continue;
+
+            m_altura[vecina] = m_altura[particula] + 1;
+            altura_maxima = std::max(altura_maxima, m_altura[vecina]);
+            m_contador.emplace_back(vecina);
+        }
+    }
+
+    for (int i = 0; i < particulas; i++)
+        if (m_altura[i] < 0)
+            m_altura[i] = altura_maxima + 1;
+
+    // Ordenamiento por conteo de mayor a menor altura, sin los soportes
+    m_marca.assign(altura_maxima + 3, 0);
+    for (int i = 0; i < particulas; i++)
+        if (!soportes[i])
+            m_marca[altura_maxima + 2 - m_altura[i]]++;
+    for (int i = 0; i < altura_maxima + 2; i++)
+        m_marca[i + 1] += m_marca[i];
+
+    m_orden_por_altura.resize(m_marca.back());
+    for (int i = particulas - 1; i >= 0; i--)
+        if (!soportes[i])
+            m_orden_por_altura[--m_marca[altura_maxima + 2 - m_altura[i]]] = i;
+}
+
+bool GrafoDeInteracciones::construido() const
+{
+    return m_construido;
+}
+
+bool GrafoDeInteracciones::coloreado() const
+{
+    return m_coloreado;
+}
+
+int GrafoDeInteracciones::cantidad_aristas() const
+{
+    return (int)m_a.size();
+}
+
+int GrafoDeInteracciones::cantidad_particulas() const
+{
+    return m_desplazamientos.empty() ? 0 : (int)m_desplazamientos.size() - 1;
+}
+
+int GrafoDeInteracciones::cantidad_colores() const
+{
+    return m_desplazamientos_color.empty() ? 0 : (int)m_desplazamientos_color.size() - 1;
+}
+
+int GrafoDeInteracciones::cantidad_islas() const
+{
+    return m_desplazamientos_isla.empty() ? 0 : (int)m_desplazamientos_isla.size() - 1;
+}
+
+int GrafoDeInteracciones::otra(int arista, int particula) const
+{
+    return (m_a[arista] == particula) ? m_b[arista] : m_a[arista];
+}
+
+Vector2 GrafoDeInteracciones::direccion(int arista, int particula) const
+{
+    Vector2 direccion(m_direccion_x[arista], m_direccion_y[arista]);
+    return (m_a[arista] == particula) ? direccion : direccion * -1.0f;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "vector.h"
+
+namespace sistema
+{
+    class Interaccion
+    {
+    public:
+        int m_particula, m_referencia;
+        Vector2 m_direccion;
+        float m_dt;
+
+    public:
+        Interaccion(int particula, int referencia, Vector2 direccion, float dt);
+    };
+
+    // Grafo de contactos en formato CSR. Cada contacto se guarda una unica vez
+    // como arista (a, b) con a < b y la direccion de a hacia b, y cada particula
+    // tiene una fila con los indices de las aristas que la tocan
+    class GrafoDeInteracciones
+    {
+    public:
+        std::vector<int> m_a, m_b;
+        std::vector<float> m_direccion_x, m_direccion_y;
+        std::vector<float> m_dt;
+
+        std::vector<int> m_desplazamientos;
+        std::vector<int> m_incidencias;
+
+        // Aristas agrupadas por color, donde dos aristas del mismo color nunca
+        // comparten una particula (salvo las que se ignoraron al colorear)
+        std::vector<int> m_color;
+        std::vector<int> m_desplazamientos_color;
+        std::vector<int> m_aristas_por_color;
+
+        // Componentes conexas del grafo, ordenadas de mayor a menor. Las
+        // particulas sin aristas o marcadas como frontera no pertenecen a
+        // ninguna isla (m_isla = -1)
+        std::vector<int> m_isla;
+        std::vector<int> m_desplazamientos_isla;
+        std::vector<int> m_particulas_por_isla;
+
+        // Distancia en aristas de cada particula al soporte mas cercano, y las
+        // particulas que no son soporte ordenadas de la mas alta a la mas baja
+        std::vector<int> m_altura;
+        std::vector<int> m_orden_por_altura;
+
+        // Epoca de la ultima iteracion en la que hubo interaccion en cada arista
+        std::vector<uint32_t> m_visita;
+
+    private:
+        std::vector<Interaccion> m_lote, m_auxiliar;
+        std::vector<int> m_contador, m_marca;
+        std::vector<int> m_padre, m_orden_islas;
+        bool m_construido, m_coloreado;
+
+    public:
+        GrafoDeInteracciones();
+
+        void agregar(int particula, int referencia, Vector2 direccion, float dt);
+        void limpiar();
+        void construir(int cantidad_particulas);
+        void colorear(const std::vector<uint8_t> &ignorar);
+        void separar_en_islas(const std::vector<uint8_t> &fronteras);
+        void ordenar_por_soporte(const std::vector<uint8_t> &soportes);
+
+        bool construido() const;
+        bool coloreado() const;
+        int cantidad_aristas() const;
+        int cantidad_particulas() const;
+        int cantidad_colores() const;
+        int cantidad_islas() const;
+
+        int otra(int arista, int particula) const;
+        Vector2 direccion(int arista, int particula) const;
+
+    private:
+        void ordenar_por(bool por_a, int cantidad_particulas);
+        int raiz(int particula);
+    };
+}
\ No newline at end of file
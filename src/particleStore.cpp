@@ -0,0 +1,166 @@
+#include "particleStore.h"
+#include "sistema.h"
+
+#include <algorithm>
+
+using namespace sistema;
+
+void ParticleStore::reservar(int cantidad)
+{
+    m_velocidad_x.reserve(cantidad);
+    m_velocidad_y.reserve(cantidad);
+    m_fuerza_x.reserve(cantidad);
+    m_fuerza_y.reserve(cantidad);
+    m_velocidad_guardada_x.reserve(cantidad);
+    m_velocidad_guardada_y.reserve(cantidad);
+    m_fuerza_guardada_x.reserve(cantidad);
+    m_fuerza_guardada_y.reserve(cantidad);
+    m_masa.reserve(cantidad);
+    m_inversa_masa.reserve(cantidad);
+    m_coeficiente.reserve(cantidad);
+    m_estatica.reserve(cantidad);
+    m_dormida.reserve(cantidad);
+    m_cuadros_quieta.reserve(cantidad);
+}
+
+int ParticleStore::agregar(const Particula &particula)
+{
+    m_velocidad_x.emplace_back(particula.m_velocidad.x);
+    m_velocidad_y.emplace_back(particula.m_velocidad.y);
+    m_fuerza_x.emplace_back(particula.m_fuerza.x);
+    m_fuerza_y.emplace_back(particula.m_fuerza.y);
+    m_velocidad_guardada_x.emplace_back(particula.m_velocidad.x);
+    m_velocidad_guardada_y.emplace_back(particula.m_velocidad.y);
+    m_fuerza_guardada_x.emplace_back(particula.m_fuerza.x);
+    m_fuerza_guardada_y.emplace_back(particula.m_fuerza.y);
+    m_masa.emplace_back(particula.m_masa);
+    m_inversa_masa.emplace_back(particula.m_estatica ? .0f : 1.0f / particula.m_masa);
+    m_coeficiente.emplace_back(particula.m_coeficiente);
+    m_estatica.emplace_back(particula.m_estatica);
+    m_dormida.emplace_back(false);
+    m_cuadros_quieta.emplace_back(0);
+
+    return cantidad() - 1;
+}
+
+int ParticleStore::cantidad() const
+{
+    return (int)m_masa.size();
+}
+
+Vector2 ParticleStore::velocidad(int indice) const
+{
+    return Vector2(m_velocidad_x[indice], m_velocidad_y[indice]);
+}
+
+Vector2 ParticleStore::fuerza(int indice) const
+{
+    return Vector2(m_fuerza_x[indice], m_fuerza_y[indice]);
+}
+
+bool ParticleStore::nulo(int indice) const
+{
+    return fuerza(indice).nulo() && velocidad(indice).nulo();
+}
+
+void ParticleStore::velocidad_por_choque(int indice, Vector2 fuerza_choque)
+{
+    if (m_estatica[indice])
+        return;
+    m_velocidad_guardada_x[indice] += fuerza_choque.x * m_inversa_masa[indice];
+    m_velocidad_guardada_y[indice] += fuerza_choque.y * m_inversa_masa[indice];
+}
+
+void ParticleStore::aplicar_fuerza(int indice, Vector2 fuerza)
+{
+    if (m_estatica[indice])
+        return;
+    m_fuerza_guardada_x[indice] += fuerza.x;
+    m_fuerza_guardada_y[indice] += fuerza.y;
+}
+
+// El peso no despierta a las particulas dormidas, ya que si no ninguna
+// particula podria dormirse
+void ParticleStore::aplicar_gravedad(Vector2 gravedad)
+{
+    const int n = cantidad();
+    float *fuerza_x = m_fuerza_x.data(), *fuerza_y = m_fuerza_y.data();
+    float *guardada_x = m_fuerza_guardada_x.data(), *guardada_y = m_fuerza_guardada_y.data();
+    const float *masa = m_masa.data();
+    const uint8_t *estatica = m_estatica.data(), *dormida = m_dormida.data();
+
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        float activa = (estatica[i] | dormida[i]) ? .0f : 1.0f;
+        fuerza_x[i] += gravedad.x * masa[i] * activa;
+        fuerza_y[i] += gravedad.y * masa[i] * activa;
+        guardada_x[i] += gravedad.x * masa[i] * activa;
+        guardada_y[i] += gravedad.y * masa[i] * activa;
+    }
+}
+
+void ParticleStore::actualizar_propiedades()
+{
+    std::copy(m_velocidad_guardada_x.begin(), m_velocidad_guardada_x.end(), m_velocidad_x.begin());
+    std::copy(m_velocidad_guardada_y.begin(), m_velocidad_guardada_y.end(), m_velocidad_y.begin());
+    std::copy(m_fuerza_guardada_x.begin(), m_fuerza_guardada_x.end(), m_fuerza_x.begin());
+    std::copy(m_fuerza_guardada_y.begin(), m_fuerza_guardada_y.end(), m_fuerza_y.begin());
+}
+
+void ParticleStore::actualizar_propiedades(const int *particulas, int cantidad)
+{
+    for (int i = 0; i < cantidad; i++)
+    {
+        int indice = particulas[i];
+        m_velocidad_x[indice] = m_velocidad_guardada_x[indice];
+        m_velocidad_y[indice] = m_velocidad_guardada_y[indice];
+        m_fuerza_x[indice] = m_fuerza_guardada_x[indice];
+        m_fuerza_y[indice] = m_fuerza_guardada_y[indice];
+    }
+}
+
+void ParticleStore::sincronizar(int indice)
+{
+    actualizar_propiedades(&indice, 1);
+}
+
+// La velocidad guardada queda igual a la integrada para que el proximo paso
+// parta de ella, y las fuerzas se consumen, por lo que hay que volver a aplicarlas
+void ParticleStore::integrar(float dt)
+{
+    const int n = cantidad();
+    float *velocidad_x = m_velocidad_x.data(), *velocidad_y = m_velocidad_y.data();
+    float *guardada_x = m_velocidad_guardada_x.data(), *guardada_y = m_velocidad_guardada_y.data();
+    float *fuerza_x = m_fuerza_x.data(), *fuerza_y = m_fuerza_y.data();
+    float *fuerza_guardada_x = m_fuerza_guardada_x.data(), *fuerza_guardada_y = m_fuerza_guardada_y.data();
+    const float *inversa_masa = m_inversa_masa.data();
+    const uint8_t *dormida = m_dormida.data();
+
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        float paso = dormida[i] ? .0f : dt * inversa_masa[i];
+        velocidad_x[i] += fuerza_x[i] * paso;
+        velocidad_y[i] += fuerza_y[i] * paso;
+        guardada_x[i] = velocidad_x[i];
+        guardada_y[i] = velocidad_y[i];
+        fuerza_x[i] = .0f;
+        fuerza_y[i] = .0f;
+        fuerza_guardada_x[i] = .0f;
+        fuerza_guardada_y[i] = .0f;
+    }
+}
+
+void ParticleStore::dormir(int indice)
+{
+    m_dormida[indice] = true;
+    m_velocidad_x[indice] = m_velocidad_y[indice] = .0f;
+    m_velocidad_guardada_x[indice] = m_velocidad_guardada_y[indice] = .0f;
+}
+
+void ParticleStore::despertar(int indice)
+{
+    m_dormida[indice] = false;
+    m_cuadros_quieta[indice] = 0;
+}
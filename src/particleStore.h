@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "vector.h"
+
+namespace sistema
+{
+    class Particula;
+
+    // Guarda el estado de las particulas de un sistema como arreglos contiguos
+    // (structure of arrays), donde cada particula se identifica por su indice
+    class ParticleStore
+    {
+    public:
+        std::vector<float> m_velocidad_x, m_velocidad_y;
+        std::vector<float> m_fuerza_x, m_fuerza_y;
+        std::vector<float> m_velocidad_guardada_x, m_velocidad_guardada_y;
+        std::vector<float> m_fuerza_guardada_x, m_fuerza_guardada_y;
+        std::vector<float> m_masa, m_inversa_masa;
+        std::vector<float> m_coeficiente;
+        std::vector<uint8_t> m_estatica;
+        std::vector<uint8_t> m_dormida;
+        std::vector<int> m_cuadros_quieta;
+
+    public:
+        void reservar(int cantidad);
+        int agregar(const Particula &particula);
+        int cantidad() const;
+
+        Vector2 velocidad(int indice) const;
+        Vector2 fuerza(int indice) const;
+        bool nulo(int indice) const;
+
+        void velocidad_por_choque(int indice, Vector2 fuerza_choque);
+        void aplicar_fuerza(int indice, Vector2 fuerza);
+        void aplicar_gravedad(Vector2 gravedad);
+
+        void actualizar_propiedades();
+        void actualizar_propiedades(const int *particulas, int cantidad);
+        void sincronizar(int indice);
+        void integrar(float dt);
+
+        void dormir(int indice);
+        void despertar(int indice);
+    };
+}
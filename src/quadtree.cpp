@@ -1,259 +1,212 @@
 #include "quadtree.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace qt;
 
-QuadTree::QuadTree(Vector2 posicion, float ancho, float alto)
-    : m_area(AABB(posicion, ancho, alto))
-{
-    m_raiz = new Node(posicion, ancho, alto);
-}
+template class qt::NodoDe<Entidad, 4, 8>;
+template class qt::QuadTree<Entidad, 4, 8>;
 
-QuadTree::QuadTree(AABB &aabb)
-    : m_area(aabb)
+bool qt::cortar_caja(const AABB &caja, Vector2 origen, Vector2 inversa, float max_t, float &entrada, float &salida, int &eje)
 {
-    m_raiz = new Node(aabb);
-}
+    float t1_x = (caja.m_posicion.x - caja.m_ancho - origen.x) * inversa.x;
+    float t2_x = (caja.m_posicion.x + caja.m_ancho - origen.x) * inversa.x;
+    float t1_y = (caja.m_posicion.y - caja.m_alto - origen.y) * inversa.y;
+    float t2_y = (caja.m_posicion.y + caja.m_alto - origen.y) * inversa.y;
 
-QuadTree::~QuadTree()
-{
-    delete m_raiz;
-}
+    float cerca_x = std::fmin(t1_x, t2_x), cerca_y = std::fmin(t1_y, t2_y);
+    float lejos_x = std::fmax(t1_x, t2_x), lejos_y = std::fmax(t1_y, t2_y);
 
-bool QuadTree::insertar(Entidad *entidad)
-{
-    return m_raiz->insertar(entidad);
+    eje = cerca_x > cerca_y ? 0 : 1;
+    entrada = std::fmax(std::fmax(cerca_x, cerca_y), .0f);
+    salida = std::fmin(std::fmin(lejos_x, lejos_y), max_t);
+    return entrada <= salida;
 }
 
-template <typename T>
-void eliminar_de_lista(std::vector<T> &lista, T elemento)
-{
-    for (auto it = lista.begin(); it < lista.end(); it++)
-        if (*it == elemento)
-            lista.erase(it);
-}
+static std::atomic<uint64_t> consultas{0};
 
-template <typename T>
-bool hay_en_lista(std::vector<T> &lista, T elemento)
+uint64_t qt::nueva_consulta()
 {
-    for (auto it = lista.begin(); it < lista.end(); it++)
-        if (*it == elemento)
-            return true;
-    return false;
+    return consultas.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
-struct Padres
-{
-    std::vector<Node *> viejos;
-    std::vector<Node *> nuevos;
-};
-
-Padres nuevos_y_viejos(Entidad *entidad, Node *raiz)
+Node::Node(const AABB &area, NodePool *pool, int profundidad)
+    : m_area(area), m_pool(pool), m_subdivisiones(nullptr), m_cant_entidades(0), m_profundidad(profundidad)
 {
-    std::vector<Node *> viejos;
-    std::vector<Node *> nuevos;
-    std::vector<Node *> padres;
-    raiz->nodos_padre(entidad, padres);
-
-    for (Node *node : entidad->m_padres)
-        if (!hay_en_lista<Node *>(padres, node))
-            viejos.emplace_back(node);
-
-    for (Node *node : padres)
-        nuevos.emplace_back(node);
-
-    return {viejos, nuevos};
 }
 
-void QuadTree::actualizar(Entidad *entidad)
+// Estrictamente adentro, ya que si toca el borde tambien colisiona con la
+// hoja vecina
+bool Node::contiene(const Caja &caja) const
 {
-    Padres padres = nuevos_y_viejos(entidad, m_raiz);
-    for (Node *node : padres.viejos)
-        node->eliminar(entidad);
-    for (Node *node : padres.nuevos)
-        node->insertar(entidad);
+    return caja.centro.x - caja.ancho > m_area.m_posicion.x - m_area.m_ancho &&
+           caja.centro.x + caja.ancho < m_area.m_posicion.x + m_area.m_ancho &&
+           caja.centro.y - caja.alto > m_area.m_posicion.y - m_area.m_alto &&
+           caja.centro.y + caja.alto < m_area.m_posicion.y + m_area.m_alto;
 }
 
-bool QuadTree::eliminar(Entidad *entidad)
+bool Node::toca(const Caja &caja) const
 {
-    return m_raiz->eliminar(entidad);
+    return std::abs(caja.centro.x - m_area.m_posicion.x) <= caja.ancho + m_area.m_ancho &&
+           std::abs(caja.centro.y - m_area.m_posicion.y) <= caja.alto + m_area.m_alto;
 }
 
-std::vector<Entidad *> QuadTree::buscar(CuerpoRigido *frontera)
+// Una entidad que esta en varias hojas se devuelve solo desde la primera de
+// sus hojas a la que llega la busqueda. Como no se marca nada en la entidad,
+// se puede volver a buscar en el arbol desde el visitante o desde otro hilo.
+// Las hojas fuera del nodo donde empezo la busqueda no cuentan, porque la
+// busqueda nunca llega a ellas
+bool Node::primera_hoja(Entidad *entidad, CuerpoRigido *frontera, const Caja &caja, const Node *inicio)
 {
-    std::vector<Entidad *> output;
-    m_raiz->buscar(frontera, output);
-    return output;
+    for (Node *padre : entidad->m_padres)
+    {
+        if (padre == this)
+            return true;
+        if (padre->toca(caja) && padre->m_area.intersecta(frontera) && inicio->contiene(padre))
+            return false;
+    }
+    return true;
 }
 
-Node::Node(Vector2 posicion, float ancho, float alto)
-    : m_area(AABB(posicion, ancho, alto)), m_cant_entidades(0)
+float Node::distancia_cuadrada(Vector2 punto) const
 {
+    float x = std::max(std::abs(punto.x - m_area.m_posicion.x) - m_area.m_ancho, .0f);
+    float y = std::max(std::abs(punto.y - m_area.m_posicion.y) - m_area.m_alto, .0f);
+    return x * x + y * y;
 }
 
-Node::Node(AABB &aabb)
-    : m_area(aabb), m_cant_entidades(0)
+bool Node::contiene(const Node *nodo) const
 {
+    return std::abs(nodo->m_area.m_posicion.x - m_area.m_posicion.x) + nodo->m_area.m_ancho <= m_area.m_ancho &&
+           std::abs(nodo->m_area.m_posicion.y - m_area.m_posicion.y) + nodo->m_area.m_alto <= m_area.m_alto;
 }
 
-Node::~Node()
+void Node::agregar(Entidad *entidad, const Caja &caja)
 {
-    if (!m_subdivisiones.empty())
-        for (Node *subdivision : m_subdivisiones)
-            delete subdivision;
+    m_entidades.emplace_back(entidad);
+    m_cajas.emplace_back(caja);
+    entidad->m_padres.emplace_back(this);
 }
 
-bool Node::insertar(Entidad *entidad)
+// Las cajas se sacan junto con su entidad, para que sigan en el mismo orden
+void Node::quitar(Entidad *entidad)
 {
-    if (!entidad->colisiona(&m_area))
-        return false;
-
-    if (m_cant_entidades < cap_entidades || !es_divisible())
+    auto it = std::find(m_entidades.begin(), m_entidades.end(), entidad);
+    if (it != m_entidades.end())
     {
-        m_entidades.emplace_back(entidad);
-        entidad->m_padres.emplace_back(this);
+        m_cajas.erase(m_cajas.begin() + (it - m_entidades.begin()));
+        m_entidades.erase(it);
     }
-    else
-    {
-        subdividir();
-        for (Node *subdivision : m_subdivisiones)
-            subdivision->insertar(entidad);
-    }
-    m_cant_entidades++;
-    return true;
+    eliminar_de_lista<Node *>(entidad->m_padres, this);
 }
 
-bool Node::eliminar(Entidad *entidad)
+void Node::refrescar(Entidad *entidad, const Caja &caja)
 {
-    if (!entidad->colisiona(&m_area))
-        return false;
+    auto it = std::find(m_entidades.begin(), m_entidades.end(), entidad);
+    if (it != m_entidades.end())
+        m_cajas[it - m_entidades.begin()] = caja;
+}
 
-    m_cant_entidades--;
-    if (!m_subdivisiones.empty())
-    {
-        for (Node *subdivision : m_subdivisiones)
-            subdivision->eliminar(entidad);
-        juntar();
-    }
-    else
-    {
-        eliminar_de_lista<Node *>(entidad->m_padres, this);
-        eliminar_de_lista<Entidad *>(m_entidades, entidad);
-    }
+AABB Node::area_de_subdivision(int indice) const
+{
+    float nuevo_ancho = m_area.m_ancho / 2;
+    float nuevo_alto = m_area.m_alto / 2;
 
-    return true;
+    float nuevo_x = m_area.m_posicion.x + nuevo_ancho * (1 - 2 * (indice % 2));
+    float nuevo_y = m_area.m_posicion.y + nuevo_alto * (1 - 2 * ((indice / 2) % 2));
+
+    return AABB(Vector2(nuevo_x, nuevo_y), nuevo_ancho, nuevo_alto);
 }
 
-void agregar_entidad_sin_repetir(std::vector<Entidad *> &lista, Entidad *entidad)
+Entidad::Entidad()
+    : m_consulta(0)
 {
-    for (Entidad *e : lista)
-        if (e == entidad)
-            return;
-    lista.emplace_back(entidad);
+    m_padres.reserve(1);
 }
 
-void Node::buscar(CuerpoRigido *frontera, std::vector<Entidad *> &output)
+PuntoDeColision Entidad::cortar(Linea *segmento)
 {
-    if (!m_area.colisiona(frontera).colisiono)
-        return;
+    Vector2 direccion = segmento->m_final - segmento->m_posicion;
+    Vector2 inversa(1.0f / direccion.x, 1.0f / direccion.y);
+
+    float entrada, salida;
+    int eje;
+    if (!cortar_caja(limites(), segmento->m_posicion, inversa, 1.0f, entrada, salida, eje))
+        return {};
 
-    if (!m_subdivisiones.empty())
-        for (Node *subdivision : m_subdivisiones)
-            subdivision->buscar(frontera, output);
-    else
-        for (Entidad *entidad : m_entidades)
-            if (entidad->colisiona(frontera))
-                agregar_entidad_sin_repetir(output, entidad);
+    Vector2 normal = eje == 0 ? Vector2(direccion.x > .0f ? -1.0f : 1.0f, .0f)
+                              : Vector2(.0f, direccion.y > .0f ? -1.0f : 1.0f);
+    Vector2 A = segmento->m_posicion + direccion * entrada;
+    Vector2 B = segmento->m_posicion + direccion * salida;
+    return {A, B, normal, (B - A).modulo(), true};
 }
 
-void Node::nodos_padre(Entidad *entidad, std::vector<Node *> &padres)
+NodePool::NodePool()
+    : m_vivos(0), m_maximo(0)
 {
-    if (!entidad->colisiona(&m_area))
-        return;
-
-    if (m_subdivisiones.empty())
-        padres.emplace_back(this);
-    else
-        for (Node *subdivision : m_subdivisiones)
-            subdivision->nodos_padre(entidad, padres);
 }
 
-std::vector<Node *> Node::crear_subdivisiones()
+// Cuando no hay grupos libres se pide un bloque entero, y sus grupos se
+// agregan a la lista en orden inverso para entregarlos de menor a mayor direccion
+Node *NodePool::reservar()
 {
-    std::vector<Node *> subdivisiones;
-
-    float nuevo_ancho = m_area.m_ancho / 2;
-    float nuevo_alto = m_area.m_alto / 2;
-
-    for (int i = 0; i < cap_subdivisiones; i++)
+    if (m_libres.empty())
     {
-        float nuevo_x = m_area.m_posicion.x + nuevo_ancho * (1 - 2 * (i % 2));
-        float nuevo_y = m_area.m_posicion.x + nuevo_alto * (1 - 2 * ((i / 2) % 2));
+        const size_t tamanio_grupo = hermanos * sizeof(Node);
+        m_bloques.emplace_back(new std::byte[grupos_por_bloque * tamanio_grupo]);
 
-        Node *subdivision = new Node(Vector2(nuevo_x, nuevo_y), nuevo_ancho, nuevo_alto);
-        subdivisiones.emplace_back(subdivision);
+        std::byte *bloque = m_bloques.back().get();
+        for (int i = grupos_por_bloque - 1; i >= 0; i--)
+            m_libres.emplace_back(reinterpret_cast<Node *>(bloque + i * tamanio_grupo));
     }
 
-    return subdivisiones;
+    Node *grupo = m_libres.back();
+    m_libres.pop_back();
+
+    m_vivos += hermanos;
+    m_maximo = std::max(m_maximo, m_vivos);
+    return grupo;
 }
 
-void Node::subdividir()
+void NodePool::liberar(Node *grupo)
 {
-    if (!m_subdivisiones.empty())
-        return;
-
-    m_subdivisiones = crear_subdivisiones();
+    m_libres.emplace_back(grupo);
+    m_vivos -= hermanos;
+}
 
-    for (Entidad *entidad : m_entidades)
-    {
-        eliminar_de_lista<Node *>(entidad->m_padres, this);
-        for (Node *subdivision : m_subdivisiones)
-            subdivision->insertar(entidad);
-    }
-    m_entidades.clear();
+// Las listas de las hojas se guardan con lo que ya reservaron, para que al
+// volver a dividir no se pida memoria de nuevo
+void NodePool::guardar_listas(std::vector<Entidad *> &entidades, std::vector<Caja> &cajas)
+{
+    entidades.clear();
+    cajas.clear();
+    m_listas_libres.emplace_back(std::move(entidades));
+    m_cajas_libres.emplace_back(std::move(cajas));
 }
 
-void Node::juntar()
+void NodePool::tomar_listas(std::vector<Entidad *> &entidades, std::vector<Caja> &cajas)
 {
-    if (m_cant_entidades >= cap_entidades)
+    if (m_listas_libres.empty())
         return;
 
-    std::vector<Entidad *> output;
-    buscar(&m_area, output);
-    m_entidades.swap(output);
-
-    for (Entidad *entidad : m_entidades)
-    {
-        for (Node *subdivision : m_subdivisiones)
-            eliminar_de_lista<Node *>(entidad->m_padres, subdivision);
-        entidad->m_padres.emplace_back(this);
-    }
-
-    for (Node *subdivision : m_subdivisiones)
-        subdivision->~Node();
-    m_subdivisiones.clear();
+    entidades = std::move(m_listas_libres.back());
+    cajas = std::move(m_cajas_libres.back());
+    m_listas_libres.pop_back();
+    m_cajas_libres.pop_back();
 }
 
-bool Node::es_divisible()
+int NodePool::vivos() const
 {
-    if (m_entidades.size() < cap_entidades - 1)
-        return true;
-
-    if (m_entidades.size() >= cap_entidades)
-        return false;
-
-    bool divisible = false;
-    for (Node *subdivision : crear_subdivisiones())
-    {
-        for (Entidad *entidad : m_entidades)
-            if (!entidad->colisiona(&subdivision->m_area))
-                divisible = true;
-        delete subdivision;
-    }
+    return m_vivos;
+}
 
-    return divisible;
+int NodePool::maximo() const
+{
+    return m_maximo;
 }
 
-Entidad::Entidad()
+int NodePool::capacidad() const
 {
-    m_padres.reserve(1);
+    return (int)m_bloques.size() * grupos_por_bloque * hermanos;
 }
@@ -1,9 +1,24 @@
 #pragma once
 
 #include "vector.h"
+#include "generador.h"
 #include "cuerpos/colisiones.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <type_traits>
 #include <vector>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <omp.h>
 
 namespace qt
 {
@@ -11,61 +26,1113 @@ namespace qt
     class Node;
     class Entidad;
 
-    class QuadTree
+    // Las entidades de un arbol tienen que ser todas exactamente del tipo E,
+    // asi las pruebas no pasan por la tabla virtual y se pueden inlinear. Con
+    // Entidad se aceptan entidades de cualquier tipo y las llamadas son virtuales
+    template <typename E>
+    concept EntidadDeArbol = std::derived_from<E, Entidad>;
+
+    // El impacto mas cercano de un rayo, en el punto origen + direccion * t
+    template <EntidadDeArbol E = Entidad>
+    struct Impacto
+    {
+        E *entidad; // nula si no toco nada
+        float t;
+        PuntoDeColision punto;
+    };
+
+    // Los limites de una entidad como los guarda la hoja: centro y mitades,
+    // igual que un AABB pero sin la tabla virtual de CuerpoRigido
+    struct Caja
+    {
+        Vector2 centro;
+        float ancho, alto;
+    };
+
+    inline Caja caja_de(const AABB &aabb)
+    {
+        return {aabb.m_posicion, aabb.m_ancho, aabb.m_alto};
+    }
+
+    inline bool se_tocan(const Caja &a, const Caja &b)
+    {
+        return std::abs(a.centro.x - b.centro.x) <= a.ancho + b.ancho &&
+               std::abs(a.centro.y - b.centro.y) <= a.alto + b.alto;
+    }
+
+    // Reparte los nodos de a cuatro hermanos contiguos, tomados de bloques
+    // grandes, y los recicla con una lista de libres cuando se juntan
+    class NodePool
     {
     private:
-        AABB m_area;
-        Node *m_raiz;
+        static const int hermanos = 4;
+        static const int grupos_por_bloque = 64;
+
+        std::vector<std::unique_ptr<std::byte[]>> m_bloques;
+        std::vector<Node *> m_libres;
+        std::vector<std::vector<Entidad *>> m_listas_libres; // las de los nodos reciclados, vacias
+        std::vector<std::vector<Caja>> m_cajas_libres;
+        int m_vivos;
+        int m_maximo;
 
     public:
-        QuadTree(Vector2 posicion, float ancho, float alto);
-        QuadTree(AABB &aabb);
-        ~QuadTree();
+        NodePool();
 
-        bool insertar(Entidad *entidad);
-        void actualizar(Entidad *entidad);
-        bool eliminar(Entidad *entidad);
-        std::vector<Entidad *> buscar(CuerpoRigido *frontera);
+        NodePool(const NodePool &) = delete;
+        NodePool &operator=(const NodePool &) = delete;
+
+        Node *reservar(); // cuatro nodos contiguos sin construir
+        void liberar(Node *grupo);
+        void guardar_listas(std::vector<Entidad *> &entidades, std::vector<Caja> &cajas);
+        void tomar_listas(std::vector<Entidad *> &entidades, std::vector<Caja> &cajas);
+
+        int vivos() const;  // nodos en uso
+        int maximo() const; // la mayor cantidad de nodos en uso a la vez
+        int capacidad() const;
     };
 
+    // Lo que tiene un nodo, sin importar como este configurado el arbol. Las
+    // entidades apuntan a sus hojas con este tipo
     class Node
     {
-    private:
-        static const int cap_subdivisiones = 4;
-        static const int cap_entidades = 4;
-
+    protected:
         AABB m_area;
-        std::vector<Node *> m_subdivisiones;
+        NodePool *m_pool;
+        Node *m_subdivisiones; // cuatro hermanos contiguos, o nullptr si es una hoja
         std::vector<Entidad *> m_entidades;
+        std::vector<Caja> m_cajas; // los limites de cada entidad, en el mismo orden
         int m_cant_entidades;
+        int m_profundidad;
 
     public:
-        Node(Vector2 posicion, float ancho, float alto);
-        Node(AABB &aabb);
-        ~Node();
+        Node(const AABB &area, NodePool *pool, int profundidad);
+
+        Node(const Node &) = delete;
+        Node &operator=(const Node &) = delete;
+
+        bool contiene(const Caja &caja) const;
+        bool contiene(const Node *nodo) const;
+        void agregar(Entidad *entidad, const Caja &caja);
+        void quitar(Entidad *entidad);
+        void refrescar(Entidad *entidad, const Caja &caja);
+
+    protected:
+        bool toca(const Caja &caja) const;
+        bool primera_hoja(Entidad *entidad, CuerpoRigido *frontera, const Caja &caja, const Node *inicio);
+        float distancia_cuadrada(Vector2 punto) const;
+        AABB area_de_subdivision(int indice) const;
+    };
+
+    // Un nodo de un arbol con hojas de hasta Capacidad entidades, que se dejan
+    // de dividir a la profundidad Profundidad
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    class NodoDe : public Node
+    {
+    private:
+        static_assert(Capacidad > 0 && Profundidad >= 0);
+
+        static const int cap_subdivisiones = 4;
+        static const int min_entidades_por_tarea = 1024;
+
+    public:
+        NodoDe(const AABB &area, NodePool *pool, int profundidad = 0);
+        ~NodoDe();
 
         bool insertar(Entidad *entidad);
-        bool eliminar(Entidad *entidad);
-        void buscar(CuerpoRigido *frontera, std::vector<Entidad *> &output);
+        bool insertar(Entidad *entidad, const Caja &caja);
+        bool eliminar(Entidad *entidad, std::pmr::memory_resource *memoria);
+        void buscar(CuerpoRigido *frontera, std::pmr::vector<E *> &output);
+        template <typename Visitante>
+        bool visitar(CuerpoRigido *frontera, const Caja &caja, const Node *inicio, Visitante &visitante);
+        Generador<E *> entidades_en(CuerpoRigido *frontera);
+        void mas_cercanas(Vector2 centro, float radio_cuadrado, int k, std::pmr::vector<E *> &output);
+        void raycast(Vector2 origen, Vector2 direccion, Vector2 inversa, Impacto<E> &impacto);
+
+        void nodos_padre(Entidad *entidad, std::pmr::vector<Node *> &padres);
+        template <typename Funcion>
+        void pares_en_colision(Funcion &funcion);
 
-        void nodos_padre(Entidad *entidad, std::vector<Node *> &padres);
+        void construir(std::span<Entidad *> entidades, std::span<const Caja> cajas);
+        void enlazar_padres();
+        void vaciar();
+
+        void contar_en_camino(std::span<Node *const> hojas, int diferencia);
+        void rebalancear(std::pmr::memory_resource *memoria);
+
+        static bool colisiona(Entidad *entidad, CuerpoRigido *area);
+        static AABB limites(Entidad *entidad);
+        static PuntoDeColision cortar(Entidad *entidad, Linea *segmento);
 
     private:
+        void nodos_padre(Entidad *entidad, const Caja &caja, std::pmr::vector<Node *> &padres);
+        template <typename Funcion>
+        void pares_en_hoja(Funcion &funcion);
         void subdividir();
-        void juntar();
+        void juntar(std::pmr::memory_resource *memoria);
         bool es_divisible();
 
-        std::vector<Node *> crear_subdivisiones();
+        NodoDe *subdivision(int indice);
+        std::span<NodoDe> subdivisiones();
+        void crear_subdivisiones();
+        void soltar_entidades();
+        void liberar_subdivisiones();
+    };
+
+    template <EntidadDeArbol E = Entidad, int Capacidad = 4, int Profundidad = 8>
+    class QuadTree
+    {
+    private:
+        using Nodo = NodoDe<E, Capacidad, Profundidad>;
+
+        struct Reubicacion
+        {
+            Entidad *entidad;
+            Caja caja;
+            size_t primera; // sus hojas nuevas en la lista de hojas del hilo
+            size_t cantidad;
+        };
+
+        AABB m_area;
+        NodePool m_pool;
+        Nodo *m_raiz;
+
+        // Una lista por hilo, para actualizar en lote
+        std::vector<std::vector<Reubicacion>> m_reubicaciones;
+        std::vector<std::pmr::vector<Node *>> m_hojas;
+
+    public:
+        QuadTree(Vector2 posicion, float ancho, float alto);
+        QuadTree(AABB &aabb);
+        ~QuadTree();
+
+        QuadTree(const QuadTree &) = delete;
+        QuadTree &operator=(const QuadTree &) = delete;
+
+        bool insertar(E *entidad);
+        int construir(std::span<E *> entidades);
+        void actualizar(E *entidad, std::pmr::memory_resource *memoria = std::pmr::get_default_resource());
+        void actualizar_lote(std::span<E *> entidades,
+                             std::pmr::memory_resource *memoria = std::pmr::get_default_resource());
+        bool eliminar(E *entidad, std::pmr::memory_resource *memoria = std::pmr::get_default_resource());
+        std::vector<E *> buscar(CuerpoRigido *frontera);
+        void buscar(CuerpoRigido *frontera, std::pmr::vector<E *> &output);
+        template <typename Visitante>
+            requires std::invocable<Visitante &, E *>
+        bool buscar(CuerpoRigido *frontera, Visitante &&visitante);
+        Generador<E *> entidades_en(CuerpoRigido *frontera);
+        std::vector<E *> buscar_radio(Vector2 centro, float radio);
+        void buscar_radio(Vector2 centro, float radio, std::pmr::vector<E *> &output);
+        std::vector<E *> k_vecinos(Vector2 centro, int k);
+        void k_vecinos(Vector2 centro, int k, std::pmr::vector<E *> &output);
+        Impacto<E> raycast(Vector2 origen, Vector2 direccion, float max_t = 1.0f);
+        template <typename Funcion>
+            requires std::invocable<Funcion &, E *, E *>
+        void pares_en_colision(Funcion &&funcion);
+
+        const NodePool &pool() const;
     };
 
     class Entidad
     {
     public:
         std::vector<Node *> m_padres;
+        uint64_t m_consulta; // la ultima busqueda por distancia que la encontro
 
     public:
         Entidad();
+        virtual ~Entidad() = default;
 
         virtual bool colisiona(CuerpoRigido *area) = 0;
+        virtual AABB limites() = 0;
+
+        // Donde el segmento entra y sale de la entidad, con la normal de la
+        // superficie donde entra. Por defecto se usan los limites
+        virtual PuntoDeColision cortar(Linea *segmento);
     };
-}
\ No newline at end of file
+
+    // Cada busqueda por distancia tiene su propio numero, compartido entre todos
+    // los arboles. Con 64 bits no se repite nunca en la practica
+    uint64_t nueva_consulta();
+
+    // Solo las entidades que estan en varias hojas pueden aparecer mas de una
+    // vez, y a esas se les marca la busqueda que ya las encontro
+    inline bool primera_vez(Entidad *entidad, uint64_t consulta)
+    {
+        if (entidad->m_padres.size() <= 1)
+            return true;
+
+        std::atomic_ref<uint64_t> marca(entidad->m_consulta);
+        if (marca.load(std::memory_order_relaxed) == consulta)
+            return false;
+        marca.store(consulta, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Prueba de franjas (slab test) del rayo origen + direccion * t, con t entre
+    // 0 y max_t, contra la caja. La inversa de la direccion viene calculada, y el
+    // eje es por donde entra (0 para x, 1 para y)
+    bool cortar_caja(const AABB &caja, Vector2 origen, Vector2 inversa, float max_t, float &entrada, float &salida,
+                     int &eje);
+
+    template <typename T>
+    void eliminar_de_lista(std::vector<T> &lista, T elemento)
+    {
+        for (auto it = lista.begin(); it < lista.end(); it++)
+            if (*it == elemento)
+                lista.erase(it);
+    }
+
+    template <typename Lista, typename T>
+    bool hay_en_lista(Lista &lista, T elemento)
+    {
+        for (auto it = lista.begin(); it < lista.end(); it++)
+            if (*it == elemento)
+                return true;
+        return false;
+    }
+
+    // QuadTree
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    QuadTree<E, Capacidad, Profundidad>::QuadTree(Vector2 posicion, float ancho, float alto)
+        : m_area(AABB(posicion, ancho, alto))
+    {
+        m_raiz = new Nodo(m_area, &m_pool);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    QuadTree<E, Capacidad, Profundidad>::QuadTree(AABB &aabb)
+        : m_area(aabb)
+    {
+        m_raiz = new Nodo(aabb, &m_pool);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    QuadTree<E, Capacidad, Profundidad>::~QuadTree()
+    {
+        delete m_raiz;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool QuadTree<E, Capacidad, Profundidad>::insertar(E *entidad)
+    {
+        return m_raiz->insertar(entidad);
+    }
+
+    // Arma el arbol de una sola vez, de arriba hacia abajo, reemplazando lo que
+    // tuviera. Cada nivel reparte las entidades entre las subdivisiones sin volver
+    // a insertarlas, y los subarboles grandes se arman en paralelo con tareas de
+    // OpenMP. Devuelve la cantidad de entidades que quedaron en el arbol
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    int QuadTree<E, Capacidad, Profundidad>::construir(std::span<E *> entidades)
+    {
+        m_raiz->vaciar();
+
+        // Los limites de cada entidad se calculan una sola vez, y bajan con ella
+        std::vector<Entidad *> adentro;
+        std::vector<Caja> cajas;
+        adentro.reserve(entidades.size());
+        cajas.reserve(entidades.size());
+        for (E *entidad : entidades)
+            if (Nodo::colisiona(entidad, &m_area))
+            {
+                adentro.emplace_back(entidad);
+                cajas.emplace_back(caja_de(Nodo::limites(entidad)));
+            }
+
+#pragma omp parallel
+#pragma omp single
+        m_raiz->construir(adentro, cajas);
+
+        // Una entidad puede quedar en hojas de distintas tareas, por lo que sus
+        // padres se enlazan al final, en serie
+        m_raiz->enlazar_padres();
+        return (int)adentro.size();
+    }
+
+    // Recorre el arbol una sola vez, con los subarboles grandes en paralelo, por
+    // lo que la funcion se puede llamar desde varios hilos a la vez
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    template <typename Funcion>
+        requires std::invocable<Funcion &, E *, E *>
+    void QuadTree<E, Capacidad, Profundidad>::pares_en_colision(Funcion &&funcion)
+    {
+#pragma omp parallel
+#pragma omp single
+        m_raiz->pares_en_colision(funcion);
+    }
+
+    // Solo se insertan los padres que la entidad todavia no tiene, si no cada
+    // actualizacion la repetiria en los nodos donde ya estaba. En los que se
+    // queda solo se refrescan sus limites
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void QuadTree<E, Capacidad, Profundidad>::actualizar(E *entidad, std::pmr::memory_resource *memoria)
+    {
+        const Caja caja = caja_de(Nodo::limites(entidad));
+        std::pmr::vector<Node *> viejos(memoria);
+        std::pmr::vector<Node *> nuevos(memoria);
+        std::pmr::vector<Node *> padres(memoria);
+        m_raiz->nodos_padre(entidad, padres);
+
+        for (Node *node : entidad->m_padres)
+            if (!hay_en_lista(padres, node))
+                viejos.emplace_back(node);
+
+        for (Node *node : padres)
+            if (!hay_en_lista(entidad->m_padres, node))
+                nuevos.emplace_back(node);
+
+        for (Node *node : viejos)
+            static_cast<Nodo *>(node)->eliminar(entidad, memoria);
+        for (Node *node : entidad->m_padres)
+            node->refrescar(entidad, caja);
+        for (Node *node : nuevos)
+            static_cast<Nodo *>(node)->insertar(entidad, caja);
+    }
+
+    // Las entidades que siguen completamente adentro de su unica hoja no se tocan.
+    // Para el resto, las hojas nuevas se buscan en paralelo (el arbol solo se lee)
+    // y solo se mueven, en serie, las que cambiaron de hojas, porque varias pueden
+    // caer en la misma. Dividir y juntar nodos se deja para una unica pasada al final
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void QuadTree<E, Capacidad, Profundidad>::actualizar_lote(std::span<E *> entidades,
+                                                              std::pmr::memory_resource *memoria)
+    {
+        const int cantidad = (int)entidades.size();
+        const int hilos = omp_get_max_threads();
+        m_reubicaciones.resize(hilos);
+        m_hojas.resize(hilos);
+        for (int hilo = 0; hilo < hilos; hilo++)
+        {
+            m_reubicaciones[hilo].clear();
+            m_hojas[hilo].clear();
+        }
+
+#pragma omp parallel
+        {
+            std::vector<Reubicacion> &reubicaciones = m_reubicaciones[omp_get_thread_num()];
+            std::pmr::vector<Node *> &hojas = m_hojas[omp_get_thread_num()];
+
+#pragma omp for schedule(static)
+            for (int i = 0; i < cantidad; i++)
+            {
+                E *entidad = entidades[i];
+                const Caja caja = caja_de(Nodo::limites(entidad));
+                if (entidad->m_padres.size() == 1 && entidad->m_padres[0]->contiene(caja))
+                {
+                    entidad->m_padres[0]->refrescar(entidad, caja);
+                    continue;
+                }
+
+                size_t primera = hojas.size();
+                m_raiz->nodos_padre(entidad, hojas);
+
+                bool mismas_hojas = hojas.size() - primera == entidad->m_padres.size();
+                for (size_t j = primera; mismas_hojas && j < hojas.size(); j++)
+                    mismas_hojas = hay_en_lista(entidad->m_padres, hojas[j]);
+
+                // Cada entidad tiene su lugar en cada hoja, por lo que se pueden
+                // refrescar en paralelo
+                if (mismas_hojas)
+                {
+                    hojas.resize(primera);
+                    for (Node *hoja : entidad->m_padres)
+                        hoja->refrescar(entidad, caja);
+                }
+                else
+                    reubicaciones.push_back({entidad, caja, primera, hojas.size() - primera});
+            }
+        }
+
+        for (int hilo = 0; hilo < hilos; hilo++)
+            for (Reubicacion reubicacion : m_reubicaciones[hilo])
+            {
+                Entidad *entidad = reubicacion.entidad;
+                m_raiz->contar_en_camino(entidad->m_padres, -1);
+                while (!entidad->m_padres.empty())
+                    entidad->m_padres.back()->quitar(entidad);
+
+                for (size_t i = 0; i < reubicacion.cantidad; i++)
+                    m_hojas[hilo][reubicacion.primera + i]->agregar(entidad, reubicacion.caja);
+                m_raiz->contar_en_camino(entidad->m_padres, 1);
+            }
+
+        m_raiz->rebalancear(memoria);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool QuadTree<E, Capacidad, Profundidad>::eliminar(E *entidad, std::pmr::memory_resource *memoria)
+    {
+        return m_raiz->eliminar(entidad, memoria);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    std::vector<E *> QuadTree<E, Capacidad, Profundidad>::buscar(CuerpoRigido *frontera)
+    {
+        std::vector<E *> output;
+        auto agregar = [&output](E *entidad)
+        {
+            output.emplace_back(entidad);
+        };
+        m_raiz->visitar(frontera, caja_de(frontera->limites()), m_raiz, agregar);
+        return output;
+    }
+
+    // La memoria de output se puede tomar de una ArenaDeCuadro, para no pedir
+    // memoria al heap en cada busqueda
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void QuadTree<E, Capacidad, Profundidad>::buscar(CuerpoRigido *frontera, std::pmr::vector<E *> &output)
+    {
+        m_raiz->buscar(frontera, output);
+    }
+
+    // El visitante recibe cada entidad encontrada, y si devuelve false se deja
+    // de buscar. Devuelve si se recorrio todo
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    template <typename Visitante>
+        requires std::invocable<Visitante &, E *>
+    bool QuadTree<E, Capacidad, Profundidad>::buscar(CuerpoRigido *frontera, Visitante &&visitante)
+    {
+        return m_raiz->visitar(frontera, caja_de(frontera->limites()), m_raiz, visitante);
+    }
+
+    // Las entidades se buscan a medida que se piden, sin armar una lista
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    Generador<E *> QuadTree<E, Capacidad, Profundidad>::entidades_en(CuerpoRigido *frontera)
+    {
+        return m_raiz->entidades_en(frontera);
+    }
+
+    // La distancia a una entidad es la distancia a su centro, y los resultados
+    // quedan ordenados de la mas cercana a la mas lejana
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    std::vector<E *> QuadTree<E, Capacidad, Profundidad>::buscar_radio(Vector2 centro, float radio)
+    {
+        std::pmr::vector<E *> output;
+        buscar_radio(centro, radio, output);
+        return std::vector<E *>(output.begin(), output.end());
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void QuadTree<E, Capacidad, Profundidad>::buscar_radio(Vector2 centro, float radio, std::pmr::vector<E *> &output)
+    {
+        m_raiz->mas_cercanas(centro, radio * radio, std::numeric_limits<int>::max(), output);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    std::vector<E *> QuadTree<E, Capacidad, Profundidad>::k_vecinos(Vector2 centro, int k)
+    {
+        std::pmr::vector<E *> output;
+        k_vecinos(centro, k, output);
+        return std::vector<E *>(output.begin(), output.end());
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void QuadTree<E, Capacidad, Profundidad>::k_vecinos(Vector2 centro, int k, std::pmr::vector<E *> &output)
+    {
+        m_raiz->mas_cercanas(centro, std::numeric_limits<float>::infinity(), k, output);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    Impacto<E> QuadTree<E, Capacidad, Profundidad>::raycast(Vector2 origen, Vector2 direccion, float max_t)
+    {
+        Impacto<E> impacto{nullptr, max_t, {}};
+        Vector2 inversa(1.0f / direccion.x, 1.0f / direccion.y);
+
+        float entrada, salida;
+        int eje;
+        if (cortar_caja(m_area, origen, inversa, max_t, entrada, salida, eje))
+            m_raiz->raycast(origen, direccion, inversa, impacto);
+        return impacto;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    const NodePool &QuadTree<E, Capacidad, Profundidad>::pool() const
+    {
+        return m_pool;
+    }
+
+    // NodoDe
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    NodoDe<E, Capacidad, Profundidad>::NodoDe(const AABB &area, NodePool *pool, int profundidad)
+        : Node(area, pool, profundidad)
+    {
+        // El pool reserva los nodos con el tamaño de Node
+        static_assert(sizeof(NodoDe) == sizeof(Node));
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    NodoDe<E, Capacidad, Profundidad>::~NodoDe()
+    {
+        liberar_subdivisiones();
+    }
+
+    // Con el tipo concreto la llamada se hace sin la tabla virtual
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool NodoDe<E, Capacidad, Profundidad>::colisiona(Entidad *entidad, CuerpoRigido *area)
+    {
+        if constexpr (std::is_abstract_v<E>)
+            return entidad->colisiona(area);
+        else
+            return static_cast<E *>(entidad)->E::colisiona(area);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    AABB NodoDe<E, Capacidad, Profundidad>::limites(Entidad *entidad)
+    {
+        if constexpr (std::is_abstract_v<E>)
+            return entidad->limites();
+        else
+            return static_cast<E *>(entidad)->E::limites();
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    PuntoDeColision NodoDe<E, Capacidad, Profundidad>::cortar(Entidad *entidad, Linea *segmento)
+    {
+        if constexpr (std::is_abstract_v<E>)
+            return entidad->cortar(segmento);
+        else
+            return static_cast<E *>(entidad)->E::cortar(segmento);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool NodoDe<E, Capacidad, Profundidad>::insertar(Entidad *entidad)
+    {
+        return insertar(entidad, caja_de(limites(entidad)));
+    }
+
+    // Con los limites se descartan los nodos que no toca sin llamar a colisiona
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool NodoDe<E, Capacidad, Profundidad>::insertar(Entidad *entidad, const Caja &caja)
+    {
+        if (!toca(caja) || !colisiona(entidad, &m_area))
+            return false;
+
+        if (m_cant_entidades < Capacidad || !es_divisible())
+            agregar(entidad, caja);
+        else
+        {
+            subdividir();
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.insertar(entidad, caja);
+        }
+        m_cant_entidades++;
+        return true;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool NodoDe<E, Capacidad, Profundidad>::eliminar(Entidad *entidad, std::pmr::memory_resource *memoria)
+    {
+        if (!colisiona(entidad, &m_area))
+            return false;
+
+        m_cant_entidades--;
+        if (m_subdivisiones != nullptr)
+        {
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.eliminar(entidad, memoria);
+            juntar(memoria);
+        }
+        else
+            quitar(entidad);
+
+        return true;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::buscar(CuerpoRigido *frontera, std::pmr::vector<E *> &output)
+    {
+        auto agregar = [&output](E *entidad)
+        {
+            output.emplace_back(entidad);
+        };
+        visitar(frontera, caja_de(frontera->limites()), this, agregar);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    template <typename Visitante>
+    bool NodoDe<E, Capacidad, Profundidad>::visitar(CuerpoRigido *frontera, const Caja &caja, const Node *inicio,
+                                                    Visitante &visitante)
+    {
+        if (!toca(caja) || !m_area.intersecta(frontera))
+            return true;
+
+        if (m_subdivisiones != nullptr)
+        {
+            for (NodoDe &subdivision : subdivisiones())
+                if (!subdivision.visitar(frontera, caja, inicio, visitante))
+                    return false;
+            return true;
+        }
+
+        // La caja guardada de cada entidad descarta casi todas sin llamar a
+        // colisiona, que solo se prueba con las que quedan
+        for (size_t i = 0; i < m_entidades.size(); i++)
+        {
+            Entidad *entidad = m_entidades[i];
+            if (!se_tocan(m_cajas[i], caja) || !colisiona(entidad, frontera) ||
+                !primera_hoja(entidad, frontera, caja, inicio))
+                continue;
+
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitante &, E *>>)
+                visitante(static_cast<E *>(entidad));
+            else if (!visitante(static_cast<E *>(entidad)))
+                return false;
+        }
+        return true;
+    }
+
+    // Recorre el subarbol con una pila propia en vez de recursion, para poder
+    // suspenderse entre entidad y entidad. El arbol no se puede modificar hasta
+    // terminar de recorrerlo
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    Generador<E *> NodoDe<E, Capacidad, Profundidad>::entidades_en(CuerpoRigido *frontera)
+    {
+        const Caja caja = caja_de(frontera->limites());
+
+        std::array<NodoDe *, cap_subdivisiones * (Profundidad + 1)> pendientes;
+        int cantidad = 0;
+        pendientes[cantidad++] = this;
+
+        while (cantidad > 0)
+        {
+            NodoDe *nodo = pendientes[--cantidad];
+            if (!nodo->toca(caja) || !nodo->m_area.intersecta(frontera))
+                continue;
+
+            if (nodo->m_subdivisiones != nullptr)
+                for (int i = cap_subdivisiones - 1; i >= 0; i--)
+                    pendientes[cantidad++] = nodo->subdivision(i);
+            else
+                for (size_t i = 0; i < nodo->m_entidades.size(); i++)
+                {
+                    Entidad *entidad = nodo->m_entidades[i];
+                    if (se_tocan(nodo->m_cajas[i], caja) && colisiona(entidad, frontera) &&
+                        nodo->primera_hoja(entidad, frontera, caja, this))
+                        co_yield static_cast<E *>(entidad);
+                }
+        }
+    }
+
+    // Busqueda de mejor primero: en la cola estan los nodos, con la distancia a su
+    // area, y las entidades, con la distancia a su centro. Como cada entidad esta
+    // en la hoja de su centro, cuando sale una entidad de la cola no queda nada
+    // mas cerca. La cola usa la misma memoria que el output
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::mas_cercanas(Vector2 centro, float radio_cuadrado, int k,
+                                                         std::pmr::vector<E *> &output)
+    {
+        struct Candidato
+        {
+            float distancia; // al cuadrado
+            NodoDe *nodo;
+            Entidad *entidad; // si no es nula, el candidato es la entidad
+
+            bool operator>(const Candidato &otro) const
+            {
+                return distancia > otro.distancia;
+            }
+        };
+
+        const uint64_t consulta = nueva_consulta();
+        std::priority_queue<Candidato, std::pmr::vector<Candidato>, std::greater<Candidato>> cola(
+            std::greater<Candidato>(), std::pmr::vector<Candidato>(output.get_allocator()));
+        cola.push({distancia_cuadrada(centro), this, nullptr});
+
+        int encontradas = 0;
+        while (!cola.empty() && encontradas < k)
+        {
+            Candidato candidato = cola.top();
+            cola.pop();
+            if (candidato.distancia > radio_cuadrado)
+                break;
+
+            if (candidato.entidad != nullptr)
+            {
+                output.emplace_back(static_cast<E *>(candidato.entidad));
+                encontradas++;
+            }
+            else if (candidato.nodo->m_subdivisiones != nullptr)
+            {
+                for (NodoDe &subdivision : candidato.nodo->subdivisiones())
+                {
+                    float distancia = subdivision.distancia_cuadrada(centro);
+                    if (distancia <= radio_cuadrado && subdivision.m_cant_entidades > 0)
+                        cola.push({distancia, &subdivision, nullptr});
+                }
+            }
+            else
+            {
+                const NodoDe *hoja = candidato.nodo;
+                for (size_t i = 0; i < hoja->m_entidades.size(); i++)
+                {
+                    if (!primera_vez(hoja->m_entidades[i], consulta))
+                        continue;
+                    float distancia = centro.distancia_cuadrada(hoja->m_cajas[i].centro);
+                    if (distancia <= radio_cuadrado)
+                        cola.push({distancia, nullptr, hoja->m_entidades[i]});
+                }
+            }
+        }
+    }
+
+    // Los hijos se recorren de adelante hacia atras segun donde entra el rayo, y
+    // se deja de bajar en cuanto entran mas lejos que el impacto mas cercano
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::raycast(Vector2 origen, Vector2 direccion, Vector2 inversa,
+                                                    Impacto<E> &impacto)
+    {
+        if (m_subdivisiones == nullptr)
+        {
+            const float largo_cuadrado = direccion * direccion;
+            Linea segmento(origen, origen + direccion * impacto.t);
+            for (Entidad *entidad : m_entidades)
+            {
+                PuntoDeColision punto = cortar(entidad, &segmento);
+                if (!punto.colisiono)
+                    continue;
+
+                float t = ((punto.A - origen) * direccion) / largo_cuadrado;
+                if (t < impacto.t || impacto.entidad == nullptr)
+                {
+                    impacto = {static_cast<E *>(entidad), t, punto};
+                    segmento.m_final = origen + direccion * t;
+                }
+            }
+            return;
+        }
+
+        // Son a lo sumo cuatro, asi que se ordenan por insercion a medida que
+        // se agregan
+        std::array<std::pair<float, int>, cap_subdivisiones> orden;
+        int cantidad = 0;
+        for (int i = 0; i < cap_subdivisiones; i++)
+        {
+            float entrada, salida;
+            int eje;
+            if (subdivision(i)->m_cant_entidades == 0 ||
+                !cortar_caja(subdivision(i)->m_area, origen, inversa, impacto.t, entrada, salida, eje))
+                continue;
+
+            int j = cantidad++;
+            for (; j > 0 && orden[j - 1].first > entrada; j--)
+                orden[j] = orden[j - 1];
+            orden[j] = {entrada, i};
+        }
+
+        for (int i = 0; i < cantidad && orden[i].first <= impacto.t; i++)
+            subdivision(orden[i].second)->raycast(origen, direccion, inversa, impacto);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::nodos_padre(Entidad *entidad, std::pmr::vector<Node *> &padres)
+    {
+        nodos_padre(entidad, caja_de(limites(entidad)), padres);
+    }
+
+    // Igual que al construir, los limites descartan los nodos que no toca antes
+    // de llamar a colisiona
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::nodos_padre(Entidad *entidad, const Caja &caja,
+                                                        std::pmr::vector<Node *> &padres)
+    {
+        if (!toca(caja) || !colisiona(entidad, &m_area))
+            return;
+
+        if (m_subdivisiones == nullptr)
+            padres.emplace_back(this);
+        else
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.nodos_padre(entidad, caja, padres);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    template <typename Funcion>
+    void NodoDe<E, Capacidad, Profundidad>::pares_en_colision(Funcion &funcion)
+    {
+        if (m_subdivisiones == nullptr)
+        {
+            pares_en_hoja(funcion);
+            return;
+        }
+
+        for (int i = 0; i < cap_subdivisiones; i++)
+        {
+            NodoDe *hijo = subdivision(i);
+#pragma omp task shared(funcion) if (hijo->m_cant_entidades >= min_entidades_por_tarea)
+            hijo->pares_en_colision(funcion);
+        }
+#pragma omp taskwait
+    }
+
+    // Como las entidades que cruzan un borde estan en todas las hojas que tocan,
+    // alcanza con probar los pares de cada hoja. Si dos entidades comparten mas de
+    // una hoja, el par se da solo en la primera hoja de la primera que tambien
+    // sea de la segunda
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    template <typename Funcion>
+    void NodoDe<E, Capacidad, Profundidad>::pares_en_hoja(Funcion &funcion)
+    {
+        for (size_t i = 0; i < m_entidades.size(); i++)
+            for (size_t j = i + 1; j < m_entidades.size(); j++)
+            {
+                if (!se_tocan(m_cajas[i], m_cajas[j]))
+                    continue;
+
+                Entidad *a = m_entidades[i], *b = m_entidades[j];
+                if (a->m_padres.size() > 1 && b->m_padres.size() > 1)
+                {
+                    auto comun = std::find_if(a->m_padres.begin(), a->m_padres.end(),
+                                              [b](Node *padre) { return hay_en_lista(b->m_padres, padre); });
+                    if (*comun != this)
+                        continue;
+                }
+                funcion(static_cast<E *>(a), static_cast<E *>(b));
+            }
+    }
+
+    // Solo se divide si sobran entidades y alguna queda afuera de alguna
+    // subdivision, igual que al insertar de a una
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::construir(std::span<Entidad *> entidades, std::span<const Caja> cajas)
+    {
+        const int cantidad = (int)entidades.size();
+        m_cant_entidades = cantidad;
+
+        if (cantidad <= Capacidad || m_profundidad >= Profundidad)
+        {
+            m_entidades.assign(entidades.begin(), entidades.end());
+            m_cajas.assign(cajas.begin(), cajas.end());
+            return;
+        }
+
+        // Los limites descartan las subdivisiones que la entidad no toca sin
+        // llamar a colisiona, que es lo mas caro
+        std::vector<Entidad *> partes[cap_subdivisiones];
+        std::vector<Caja> cajas_partes[cap_subdivisiones];
+        const float medio_x = m_area.m_posicion.x, medio_y = m_area.m_posicion.y;
+        for (int j = 0; j < cantidad; j++)
+        {
+            const Caja &caja = cajas[j];
+            bool izquierda = caja.centro.x - caja.ancho <= medio_x;
+            bool derecha = caja.centro.x + caja.ancho >= medio_x;
+            bool abajo = caja.centro.y - caja.alto <= medio_y;
+            bool arriba = caja.centro.y + caja.alto >= medio_y;
+            bool toca[cap_subdivisiones] = {derecha && arriba, izquierda && arriba, derecha && abajo,
+                                            izquierda && abajo};
+
+            for (int i = 0; i < cap_subdivisiones; i++)
+            {
+                AABB area = area_de_subdivision(i);
+                if (toca[i] && colisiona(entidades[j], &area))
+                {
+                    partes[i].emplace_back(entidades[j]);
+                    cajas_partes[i].emplace_back(caja);
+                }
+            }
+        }
+
+        bool divisible = false;
+        for (int i = 0; i < cap_subdivisiones; i++)
+            divisible |= (int)partes[i].size() < cantidad;
+
+        if (!divisible)
+        {
+            m_entidades.assign(entidades.begin(), entidades.end());
+            m_cajas.assign(cajas.begin(), cajas.end());
+            return;
+        }
+
+        crear_subdivisiones();
+
+        for (int i = 0; i < cap_subdivisiones; i++)
+        {
+            NodoDe *hijo = subdivision(i);
+#pragma omp task shared(partes, cajas_partes) if (cantidad >= min_entidades_por_tarea)
+            hijo->construir(partes[i], cajas_partes[i]);
+        }
+#pragma omp taskwait
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::enlazar_padres()
+    {
+        if (m_subdivisiones != nullptr)
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.enlazar_padres();
+        else
+            for (Entidad *entidad : m_entidades)
+                entidad->m_padres.emplace_back(this);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::vaciar()
+    {
+        soltar_entidades();
+        liberar_subdivisiones();
+        m_entidades.clear();
+        m_cajas.clear();
+        m_cant_entidades = 0;
+    }
+
+    // Mantiene la cantidad de entidades de cada nodo como si se hubieran
+    // insertado o eliminado de a una: cuenta una vez en cada nodo que tenga
+    // alguna de las hojas en su subarbol
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::contar_en_camino(std::span<Node *const> hojas, int diferencia)
+    {
+        bool en_subarbol = false;
+        for (Node *hoja : hojas)
+            en_subarbol = en_subarbol || contiene(hoja);
+        if (!en_subarbol)
+            return;
+
+        m_cant_entidades += diferencia;
+        for (NodoDe &subdivision : subdivisiones())
+            subdivision.contar_en_camino(hojas, diferencia);
+    }
+
+    // Divide las hojas que quedaron con demasiadas entidades y junta los nodos
+    // que quedaron con pocas, de abajo hacia arriba
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::rebalancear(std::pmr::memory_resource *memoria)
+    {
+        if (m_subdivisiones == nullptr)
+        {
+            if (m_cant_entidades > Capacidad && es_divisible())
+                subdividir();
+            return;
+        }
+
+        for (NodoDe &subdivision : subdivisiones())
+            subdivision.rebalancear(memoria);
+        juntar(memoria);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::subdividir()
+    {
+        if (m_subdivisiones != nullptr)
+            return;
+
+        crear_subdivisiones();
+        for (size_t i = 0; i < m_entidades.size(); i++)
+        {
+            eliminar_de_lista<Node *>(m_entidades[i]->m_padres, this);
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.insertar(m_entidades[i], m_cajas[i]);
+        }
+        m_entidades.clear();
+        m_cajas.clear();
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::juntar(std::pmr::memory_resource *memoria)
+    {
+        if (m_cant_entidades >= Capacidad)
+            return;
+
+        std::pmr::vector<E *> output(memoria);
+        buscar(&m_area, output);
+        m_entidades.assign(output.begin(), output.end());
+        m_cajas.clear();
+        for (Entidad *entidad : m_entidades)
+            m_cajas.emplace_back(caja_de(limites(entidad)));
+
+        for (NodoDe &subdivision : subdivisiones())
+            subdivision.soltar_entidades();
+        for (Entidad *entidad : m_entidades)
+            entidad->m_padres.emplace_back(this);
+
+        liberar_subdivisiones();
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    NodoDe<E, Capacidad, Profundidad> *NodoDe<E, Capacidad, Profundidad>::subdivision(int indice)
+    {
+        return static_cast<NodoDe *>(m_subdivisiones) + indice;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    std::span<NodoDe<E, Capacidad, Profundidad>> NodoDe<E, Capacidad, Profundidad>::subdivisiones()
+    {
+        if (m_subdivisiones == nullptr)
+            return {};
+        return std::span<NodoDe>(subdivision(0), cap_subdivisiones);
+    }
+
+    // Al construir en paralelo varias tareas pueden pedir nodos a la vez
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::crear_subdivisiones()
+    {
+        Node *grupo;
+#pragma omp critical(pool_de_nodos)
+        grupo = m_pool->reservar();
+
+        NodoDe *hijos = reinterpret_cast<NodoDe *>(grupo);
+        for (int i = 0; i < cap_subdivisiones; i++)
+            new (&hijos[i]) NodoDe(area_de_subdivision(i), m_pool, m_profundidad + 1);
+#pragma omp critical(pool_de_nodos)
+        for (int i = 0; i < cap_subdivisiones; i++)
+            m_pool->tomar_listas(hijos[i].m_entidades, hijos[i].m_cajas);
+        m_subdivisiones = hijos;
+    }
+
+    // Saca a las hojas de este subarbol de los padres de sus entidades, incluso
+    // las que estan a mas de un nivel, para que no queden apuntando a nodos que
+    // se van a reciclar
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::soltar_entidades()
+    {
+        if (m_subdivisiones != nullptr)
+            for (NodoDe &subdivision : subdivisiones())
+                subdivision.soltar_entidades();
+        else
+            for (Entidad *entidad : m_entidades)
+                eliminar_de_lista<Node *>(entidad->m_padres, this);
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    void NodoDe<E, Capacidad, Profundidad>::liberar_subdivisiones()
+    {
+        if (m_subdivisiones == nullptr)
+            return;
+
+        for (NodoDe &subdivision : subdivisiones())
+        {
+            subdivision.liberar_subdivisiones();
+            m_pool->guardar_listas(subdivision.m_entidades, subdivision.m_cajas);
+            subdivision.~NodoDe();
+        }
+        m_pool->liberar(m_subdivisiones);
+        m_subdivisiones = nullptr;
+    }
+
+    template <EntidadDeArbol E, int Capacidad, int Profundidad>
+    bool NodoDe<E, Capacidad, Profundidad>::es_divisible()
+    {
+        if (m_subdivisiones != nullptr)
+            return true;
+
+        if (m_profundidad >= Profundidad)
+            return false;
+
+        // Solo conviene dividir si alguna entidad queda afuera de alguna
+        // subdivision. Las areas de prueba se arman en el stack, sin crear los nodos
+        bool divisible = false;
+        for (int i = 0; i < cap_subdivisiones; i++)
+        {
+            AABB area = area_de_subdivision(i);
+            for (Entidad *entidad : m_entidades)
+                if (!colisiona(entidad, &area))
+                    divisible = true;
+        }
+
+        return divisible;
+    }
+
+    // La configuracion por defecto se compila una sola vez, en quadtree.cpp
+    extern template class NodoDe<Entidad, 4, 8>;
+    extern template class QuadTree<Entidad, 4, 8>;
+}
@@ -0,0 +1,208 @@
+#include "quadtreeHolgado.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace qt;
+
+QuadTreeHolgado::QuadTreeHolgado(Vector2 posicion, float ancho, float alto, float holgura)
+    : m_area(AABB(posicion, ancho, alto)), m_holgura(holgura), m_nodos(1)
+{
+}
+
+QuadTreeHolgado::QuadTreeHolgado(AABB &aabb, float holgura)
+    : QuadTreeHolgado(aabb.m_posicion, aabb.m_ancho, aabb.m_alto, holgura)
+{
+}
+
+// Si ya estaba y sigue en la misma celda no hay nada que hacer
+bool QuadTreeHolgado::insertar(Entidad *entidad)
+{
+    Ubicacion nueva;
+    if (!ubicar(entidad->limites(), nueva))
+        return false;
+
+    auto [it, es_nueva] = m_ubicaciones.try_emplace(entidad, nueva);
+    if (!es_nueva)
+    {
+        Ubicacion &vieja = it->second;
+        if (vieja.nivel == nueva.nivel && vieja.x == nueva.x && vieja.y == nueva.y)
+            return true;
+        sacar(entidad, vieja);
+    }
+
+    nueva.nodo = recorrer(nueva, 1);
+    nueva.indice = (int)m_nodos[nueva.nodo].entidades.size();
+    m_nodos[nueva.nodo].entidades.emplace_back(entidad);
+    it->second = nueva;
+    return true;
+}
+
+void QuadTreeHolgado::actualizar(Entidad *entidad)
+{
+    if (!insertar(entidad))
+        eliminar(entidad);
+}
+
+bool QuadTreeHolgado::eliminar(Entidad *entidad)
+{
+    auto it = m_ubicaciones.find(entidad);
+    if (it == m_ubicaciones.end())
+        return false;
+
+    sacar(entidad, it->second);
+    m_ubicaciones.erase(it);
+    return true;
+}
+
+std::vector<Entidad *> QuadTreeHolgado::buscar(CuerpoRigido *frontera)
+{
+    std::pmr::vector<Entidad *> output;
+    buscar(frontera, output);
+    return std::vector<Entidad *>(output.begin(), output.end());
+}
+
+void QuadTreeHolgado::buscar(CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output)
+{
+    visitar(0, 0, m_area.m_posicion, frontera->limites(), frontera, output);
+}
+
+int QuadTreeHolgado::cantidad() const
+{
+    return (int)m_ubicaciones.size();
+}
+
+int QuadTreeHolgado::nodos() const
+{
+    return (int)(m_nodos.size() - 4 * m_libres.size());
+}
+
+// Baja mientras la entidad entre en el nodo hijo agrandado: con el centro en
+// la celda, entra si su mitad no supera (holgura - 1) veces la mitad de la
+// celda. Las entidades se aceptan solo si su centro esta dentro del area
+bool QuadTreeHolgado::ubicar(AABB limites, Ubicacion &ubicacion) const
+{
+    float relativa_x = (limites.m_posicion.x - m_area.m_posicion.x + m_area.m_ancho) / (2.0f * m_area.m_ancho);
+    float relativa_y = (limites.m_posicion.y - m_area.m_posicion.y + m_area.m_alto) / (2.0f * m_area.m_alto);
+    if (relativa_x < .0f || relativa_y < .0f || relativa_x > 1.0f || relativa_y > 1.0f)
+        return false;
+
+    const float margen = m_holgura - 1.0f;
+    int nivel = 0;
+    while (nivel < max_profundidad)
+    {
+        float divisor = (float)(2u << nivel);
+        if (limites.m_ancho > margen * m_area.m_ancho / divisor || limites.m_alto > margen * m_area.m_alto / divisor)
+            break;
+        nivel++;
+    }
+
+    const uint32_t lado = 1u << nivel;
+    ubicacion.nivel = nivel;
+    ubicacion.x = std::min(lado - 1, (uint32_t)(relativa_x * lado));
+    ubicacion.y = std::min(lado - 1, (uint32_t)(relativa_y * lado));
+    return true;
+}
+
+// Baja desde la raiz hasta el nodo de la ubicacion sumando la diferencia a la
+// cantidad de cada nodo del camino. Al sumar crea los nodos que falten, y al
+// restar libera los subarboles que quedan vacios
+int QuadTreeHolgado::recorrer(const Ubicacion &ubicacion, int diferencia)
+{
+    int nodo = 0;
+    m_nodos[nodo].cantidad += diferencia;
+
+    for (int nivel = 1; nivel <= ubicacion.nivel; nivel++)
+    {
+        if (m_nodos[nodo].cantidad == 0)
+        {
+            liberar_hijos(nodo);
+            return -1;
+        }
+        if (m_nodos[nodo].hijos < 0)
+        {
+            int hijos = reservar_hijos();
+            m_nodos[nodo].hijos = hijos;
+        }
+
+        uint32_t desplazamiento = ubicacion.nivel - nivel;
+        uint32_t hijo = ((ubicacion.x >> desplazamiento) & 1) + 2 * ((ubicacion.y >> desplazamiento) & 1);
+        nodo = m_nodos[nodo].hijos + hijo;
+        m_nodos[nodo].cantidad += diferencia;
+    }
+
+    if (m_nodos[nodo].cantidad == 0)
+        liberar_hijos(nodo);
+    return nodo;
+}
+
+// Saca la entidad de su nodo cambiandola por la ultima, para no correr al resto
+void QuadTreeHolgado::sacar(Entidad *entidad, const Ubicacion &ubicacion)
+{
+    std::vector<Entidad *> &entidades = m_nodos[ubicacion.nodo].entidades;
+    Entidad *ultima = entidades.back();
+    entidades[ubicacion.indice] = ultima;
+    entidades.pop_back();
+    if (ultima != entidad)
+        m_ubicaciones[ultima].indice = ubicacion.indice;
+
+    recorrer(ubicacion, -1);
+}
+
+int QuadTreeHolgado::reservar_hijos()
+{
+    if (!m_libres.empty())
+    {
+        int hijos = m_libres.back();
+        m_libres.pop_back();
+        return hijos;
+    }
+
+    int hijos = (int)m_nodos.size();
+    m_nodos.resize(m_nodos.size() + 4);
+    return hijos;
+}
+
+void QuadTreeHolgado::liberar_hijos(int nodo)
+{
+    int hijos = m_nodos[nodo].hijos;
+    if (hijos < 0)
+        return;
+
+    for (int i = 0; i < 4; i++)
+    {
+        liberar_hijos(hijos + i);
+        m_nodos[hijos + i].cantidad = 0;
+        m_nodos[hijos + i].entidades.clear();
+    }
+    m_libres.emplace_back(hijos);
+    m_nodos[nodo].hijos = -1;
+}
+
+// Los nodos se descartan con sus limites agrandados antes de entrar, menos la
+// raiz, que ademas guarda las entidades demasiado grandes para cualquier nivel
+void QuadTreeHolgado::visitar(int nodo, int nivel, Vector2 centro, const AABB &limites, CuerpoRigido *frontera,
+                              std::pmr::vector<Entidad *> &output)
+{
+    const Nodo &actual = m_nodos[nodo];
+    for (Entidad *entidad : actual.entidades)
+        if (entidad->colisiona(frontera))
+            output.emplace_back(entidad);
+
+    if (actual.hijos < 0)
+        return;
+
+    const float mitad_x = m_area.m_ancho / (float)(2u << nivel);
+    const float mitad_y = m_area.m_alto / (float)(2u << nivel);
+    const float alcance_x = limites.m_ancho + m_holgura * mitad_x;
+    const float alcance_y = limites.m_alto + m_holgura * mitad_y;
+
+    for (int i = 0; i < 4; i++)
+    {
+        Vector2 centro_hijo(centro.x + (i & 1 ? mitad_x : -mitad_x), centro.y + (i & 2 ? mitad_y : -mitad_y));
+        if (m_nodos[actual.hijos + i].cantidad == 0 || std::abs(limites.m_posicion.x - centro_hijo.x) > alcance_x ||
+            std::abs(limites.m_posicion.y - centro_hijo.y) > alcance_y)
+            continue;
+        visitar(actual.hijos + i, nivel + 1, centro_hijo, limites, frontera, output);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "vector.h"
+#include "quadtree.h"
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+
+namespace qt
+{
+    // Quadtree holgado (loose quadtree). Los limites de cada nodo se agrandan
+    // por un factor de holgura, por lo que cada entidad se guarda en un solo
+    // nodo, elegido por la celda de su centro y por su tamaño. Asi no hay
+    // entidades en varias hojas, las busquedas no repiten resultados, y al
+    // actualizar solo se mueve si cambia de celda
+    class QuadTreeHolgado
+    {
+    private:
+        static const int max_profundidad = 8;
+
+        struct Nodo
+        {
+            int hijos = -1;   // los cuatro hijos son contiguos, o -1 si no tiene
+            int cantidad = 0; // entidades en todo el subarbol
+            std::vector<Entidad *> entidades;
+        };
+
+        struct Ubicacion
+        {
+            int nivel;
+            uint32_t x, y; // celda dentro del nivel
+            int nodo;
+            int indice; // posicion en las entidades del nodo
+        };
+
+        AABB m_area;
+        float m_holgura;
+
+        std::vector<Nodo> m_nodos; // el primero es la raiz
+        std::vector<int> m_libres; // grupos de hijos para reutilizar
+        std::unordered_map<Entidad *, Ubicacion> m_ubicaciones;
+
+    public:
+        QuadTreeHolgado(Vector2 posicion, float ancho, float alto, float holgura = 2.0f);
+        QuadTreeHolgado(AABB &aabb, float holgura = 2.0f);
+
+        bool insertar(Entidad *entidad);
+        void actualizar(Entidad *entidad);
+        bool eliminar(Entidad *entidad);
+        std::vector<Entidad *> buscar(CuerpoRigido *frontera);
+        void buscar(CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output);
+
+        int cantidad() const;
+        int nodos() const; // nodos en uso
+
+    private:
+        bool ubicar(AABB limites, Ubicacion &ubicacion) const;
+        int recorrer(const Ubicacion &ubicacion, int diferencia);
+        void sacar(Entidad *entidad, const Ubicacion &ubicacion);
+
+        int reservar_hijos();
+        void liberar_hijos(int nodo);
+
+        void visitar(int nodo, int nivel, Vector2 centro, const AABB &limites, CuerpoRigido *frontera,
+                     std::pmr::vector<Entidad *> &output);
+    };
+}
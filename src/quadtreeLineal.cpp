@@ -0,0 +1,208 @@
+#include "quadtreeLineal.h"
+
+#include <algorithm>
+
+using namespace qt;
+
+bool QuadTreeLineal::Registro::operator<(const Registro &otro) const
+{
+    return clave < otro.clave || (clave == otro.clave && entidad < otro.entidad);
+}
+
+bool QuadTreeLineal::Registro::operator==(const Registro &otro) const
+{
+    return clave == otro.clave && entidad == otro.entidad;
+}
+
+QuadTreeLineal::QuadTreeLineal(Vector2 posicion, float ancho, float alto)
+    : m_area(AABB(posicion, ancho, alto)), m_minimo(posicion - Vector2(ancho, alto)), m_extension(), m_viejos(0)
+{
+    float lado = (float)(1u << niveles);
+    m_escala = Vector2(lado / (2.0f * ancho), lado / (2.0f * alto));
+}
+
+QuadTreeLineal::QuadTreeLineal(AABB &aabb)
+    : QuadTreeLineal(aabb.m_posicion, aabb.m_ancho, aabb.m_alto)
+{
+}
+
+bool QuadTreeLineal::insertar(Entidad *entidad)
+{
+    uint32_t clave;
+    if (!calcular_clave(entidad->limites(), clave))
+        return false;
+
+    auto [it, nueva] = m_claves.try_emplace(entidad, clave);
+    if (!nueva && it->second == clave)
+        return true;
+    if (!nueva)
+        m_viejos++;
+
+    it->second = clave;
+    m_pendientes.push_back({clave, entidad});
+    return true;
+}
+
+// Si la celda no cambio no hay nada que hacer, que es lo mas comun cuando las
+// entidades se mueven poco entre cuadros
+void QuadTreeLineal::actualizar(Entidad *entidad)
+{
+    if (!insertar(entidad))
+        eliminar(entidad);
+}
+
+bool QuadTreeLineal::eliminar(Entidad *entidad)
+{
+    if (m_claves.erase(entidad) == 0)
+        return false;
+    m_viejos++;
+    return true;
+}
+
+std::vector<Entidad *> QuadTreeLineal::buscar(CuerpoRigido *frontera)
+{
+    std::pmr::vector<Entidad *> output;
+    buscar(frontera, output);
+    return std::vector<Entidad *>(output.begin(), output.end());
+}
+
+void QuadTreeLineal::buscar(CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output)
+{
+    ordenar();
+
+    AABB limites = frontera->limites();
+    limites.m_ancho += m_extension.x;
+    limites.m_alto += m_extension.y;
+
+    uint32_t rango[4];
+    if (!celdas(limites, rango[0], rango[1], rango[2], rango[3]))
+        return;
+
+    visitar(0, 0, 0, 0, 0, m_registros.size(), rango, frontera, output);
+}
+
+// Los cambios se acumulan y se aplican todos juntos: se descartan los registros
+// viejos, se ordenan los nuevos y se mezclan con los que ya estaban ordenados.
+// Buscar ordena si hace falta, pero si se busca desde varios hilos a la vez
+// hay que llamarlo antes
+void QuadTreeLineal::ordenar()
+{
+    if (m_pendientes.empty() && m_viejos == 0)
+        return;
+
+    auto viejo = [this](const Registro &registro)
+    {
+        auto it = m_claves.find(registro.entidad);
+        return it == m_claves.end() || it->second != registro.clave;
+    };
+
+    if (m_viejos > 0)
+        std::erase_if(m_registros, viejo);
+    std::erase_if(m_pendientes, viejo);
+    std::sort(m_pendientes.begin(), m_pendientes.end());
+
+    m_auxiliar.resize(m_registros.size() + m_pendientes.size());
+    std::merge(m_registros.begin(), m_registros.end(), m_pendientes.begin(), m_pendientes.end(), m_auxiliar.begin());
+    m_auxiliar.erase(std::unique(m_auxiliar.begin(), m_auxiliar.end()), m_auxiliar.end());
+
+    m_registros.swap(m_auxiliar);
+    m_pendientes.clear();
+    m_viejos = 0;
+}
+
+int QuadTreeLineal::cantidad() const
+{
+    return (int)m_claves.size();
+}
+
+// Intercala los bits de x (posiciones pares) y de y (posiciones impares)
+static uint32_t morton(uint32_t x, uint32_t y)
+{
+    auto separar = [](uint32_t v)
+    {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return separar(x) | (separar(y) << 1);
+}
+
+// La extension solo crece, por lo que despues de eliminar una entidad grande
+// las busquedas siguen agrandandose por ella
+bool QuadTreeLineal::calcular_clave(AABB limites, uint32_t &clave)
+{
+    uint32_t x0, y0, x1, y1;
+    if (!celdas(limites, x0, y0, x1, y1))
+        return false;
+
+    AABB centro(limites.m_posicion, .0f, .0f);
+    celdas(centro, x0, y0, x1, y1);
+    clave = morton(x0, y0);
+
+    m_extension.x = std::max(m_extension.x, limites.m_ancho);
+    m_extension.y = std::max(m_extension.y, limites.m_alto);
+    return true;
+}
+
+bool QuadTreeLineal::celdas(AABB limites, uint32_t &x0, uint32_t &y0, uint32_t &x1, uint32_t &y1) const
+{
+    const float lado = (float)(1u << niveles);
+
+    float minimo_x = (limites.m_posicion.x - limites.m_ancho - m_minimo.x) * m_escala.x;
+    float maximo_x = (limites.m_posicion.x + limites.m_ancho - m_minimo.x) * m_escala.x;
+    float minimo_y = (limites.m_posicion.y - limites.m_alto - m_minimo.y) * m_escala.y;
+    float maximo_y = (limites.m_posicion.y + limites.m_alto - m_minimo.y) * m_escala.y;
+
+    if (maximo_x < .0f || maximo_y < .0f || minimo_x >= lado || minimo_y >= lado)
+        return false;
+
+    auto celda = [lado](float valor)
+    {
+        return (uint32_t)std::clamp(valor, .0f, lado - 1.0f);
+    };
+
+    x0 = celda(minimo_x), y0 = celda(minimo_y);
+    x1 = celda(maximo_x), y1 = celda(maximo_y);
+    return true;
+}
+
+// Recorre las celdas que tocan el rango buscado. Si la celda no tiene
+// entidades en su subarbol se corta, y si tiene pocas o esta completamente
+// adentro del rango se prueban todas sin seguir bajando
+void QuadTreeLineal::visitar(uint32_t codigo, int nivel, uint32_t x, uint32_t y, size_t primero, size_t ultimo,
+                             const uint32_t rango[4], CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output)
+{
+    const uint64_t lado = (uint64_t)1 << (niveles - nivel);
+    const uint64_t hasta = (uint64_t)codigo + lado * lado;
+
+    auto comparar = [](const Registro &registro, uint64_t clave)
+    {
+        return registro.clave < clave;
+    };
+    auto inicio = std::lower_bound(m_registros.begin() + primero, m_registros.begin() + ultimo, codigo, comparar);
+    auto fin = std::lower_bound(inicio, m_registros.begin() + ultimo, hasta, comparar);
+    if (inicio == fin)
+        return;
+
+    bool adentro = x >= rango[0] && y >= rango[1] && x + lado - 1 <= rango[2] && y + lado - 1 <= rango[3];
+    if (adentro || fin - inicio <= cap_rango || nivel == niveles)
+    {
+        for (auto it = inicio; it != fin; it++)
+            if (it->entidad->colisiona(frontera))
+                output.emplace_back(it->entidad);
+        return;
+    }
+
+    const uint32_t mitad = (uint32_t)(lado / 2);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        uint32_t hijo_x = x + (i & 1) * mitad, hijo_y = y + (i >> 1) * mitad;
+        if (hijo_x > rango[2] || hijo_y > rango[3] || hijo_x + mitad - 1 < rango[0] || hijo_y + mitad - 1 < rango[1])
+            continue;
+        visitar(codigo + i * mitad * mitad, nivel + 1, hijo_x, hijo_y, inicio - m_registros.begin(),
+                fin - m_registros.begin(), rango, frontera, output);
+    }
+}
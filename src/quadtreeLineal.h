@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vector.h"
+#include "quadtree.h"
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+
+namespace qt
+{
+    // Quadtree sin punteros. Cada entidad se guarda una sola vez, con el codigo
+    // de Morton (orden Z) de la celda del ultimo nivel donde cae su centro. Como
+    // las entidades estan ordenadas por codigo, todo el subarbol de una celda es
+    // un rango contiguo del arreglo, y las busquedas se agrandan por la mayor
+    // extension de las entidades para no perder las que sobresalen de su celda
+    class QuadTreeLineal
+    {
+    private:
+        static const int niveles = 16;
+        static const int cap_rango = 8; // con menos entidades se prueban todas sin bajar
+
+        struct Registro
+        {
+            uint32_t clave; // codigo de Morton de la celda
+            Entidad *entidad;
+
+            bool operator<(const Registro &otro) const;
+            bool operator==(const Registro &otro) const;
+        };
+
+        AABB m_area;
+        Vector2 m_minimo;
+        Vector2 m_escala; // celdas del ultimo nivel por unidad
+        Vector2 m_extension; // la mayor mitad de ancho y de alto de las entidades
+
+        std::vector<Registro> m_registros;
+        std::vector<Registro> m_pendientes;
+        std::vector<Registro> m_auxiliar;
+        std::unordered_map<Entidad *, uint32_t> m_claves;
+        int m_viejos; // registros que quedaron con una clave desactualizada
+
+    public:
+        QuadTreeLineal(Vector2 posicion, float ancho, float alto);
+        QuadTreeLineal(AABB &aabb);
+
+        bool insertar(Entidad *entidad);
+        void actualizar(Entidad *entidad);
+        bool eliminar(Entidad *entidad);
+        std::vector<Entidad *> buscar(CuerpoRigido *frontera);
+        void buscar(CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output);
+
+        void ordenar();
+        int cantidad() const;
+
+    private:
+        bool calcular_clave(AABB limites, uint32_t &clave);
+        bool celdas(AABB limites, uint32_t &x0, uint32_t &y0, uint32_t &x1, uint32_t &y1) const;
+        void visitar(uint32_t codigo, int nivel, uint32_t x, uint32_t y, size_t primero, size_t ultimo,
+                     const uint32_t rango[4], CuerpoRigido *frontera, std::pmr::vector<Entidad *> &output);
+    };
+}
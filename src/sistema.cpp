@@ -1,173 +1,521 @@
 #include "sistema.h"
 
-using namespace sistema;
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-template <typename T>
-bool insertar_sin_repetir(std::vector<T> &lista, T elemento)
-{
-    for (T e : lista)
-        if (e == elemento)
-            return false;
-    lista.emplace_back(elemento);
-    return true;
-}
+using namespace sistema;
 
 Sistema::Sistema(std::vector<Particula *> &particulas, float dt)
-    : m_dt(dt)
+    : m_epoca(0), m_dt(dt),
+      m_velocidad_de_sueno(.1f), m_cuadros_de_sueno(30), m_despertadas_pendientes(0), m_estadisticas({})
 {
     for (Particula *particula : particulas)
-        insertar_sin_repetir<Particula *>(m_particulas, particula);
+        particula->m_indice = -1;
+
+    m_particulas.reserve(particulas.size());
+    m_store.reservar(particulas.size());
+    for (Particula *particula : particulas)
+    {
+        if (particula->m_indice >= 0)
+            continue;
+        particula->m_indice = m_store.agregar(*particula);
+        m_particulas.emplace_back(particula);
+    }
 }
 
 void Sistema::agregar_interaccion(Particula *particula, Particula *referencia, Vector2 &direccion)
 {
-    particula->agregar_interaccion(referencia, direccion, m_dt);
+    m_grafo.agregar(particula->m_indice, referencia->m_indice, direccion, m_dt);
 }
 
-void Sistema::expandir_interacciones()
+void Sistema::agregar_interaccion(int particula, int referencia, Vector2 direccion)
 {
-    bool terminado = false;
-    for (int i = 0; i < 10 && !terminado; i++)
+    m_grafo.agregar(particula, referencia, direccion, m_dt);
+}
+
+void Sistema::limpiar_interacciones()
+{
+    m_grafo.limpiar();
+}
+
+void Sistema::aplicar_fuerza(Particula *particula, Vector2 fuerza)
+{
+    int indice = particula->m_indice;
+    if (m_store.m_estatica[indice])
+        return;
+
+    if (m_store.m_dormida[indice])
     {
-        terminado = true;
-        for (Particula *particula : m_particulas)
-            terminado &= particula->expandir();
+        m_store.despertar(indice);
+        m_despertadas_pendientes++;
+    }
+
+    m_store.m_fuerza_x[indice] += fuerza.x;
+    m_store.m_fuerza_y[indice] += fuerza.y;
+    m_store.aplicar_fuerza(indice, fuerza);
+}
 
-        for (Particula *particula : m_particulas)
-            particula->actualizar_propiedades();
+void Sistema::aplicar_gravedad(Vector2 gravedad)
+{
+    m_store.aplicar_gravedad(gravedad);
+}
+
+void Sistema::usar_modo(ModoDelSolver modo)
+{
+    m_configuracion.modo = modo;
+}
+
+// Se deja de iterar cuando el mayor impulso de una iteracion es menor o igual
+// a la tolerancia, se llega al maximo de iteraciones o se pasa del presupuesto.
+// Con tolerancia cero, se itera hasta que no haya ninguna interaccion
+void Sistema::configurar_solver(const ConfiguracionDelSolver &configuracion)
+{
+    m_configuracion = configuracion;
+}
+
+// Una particula se duerme, junto con su isla, despues de tener una velocidad
+// menor a velocidad_minima durante la cantidad de cuadros dada. Con cuadros
+// menor o igual a cero nunca se duermen
+void Sistema::configurar_sueno(float velocidad_minima, int cuadros)
+{
+    m_velocidad_de_sueno = velocidad_minima;
+    m_cuadros_de_sueno = cuadros;
+}
+
+Estadisticas Sistema::expandir_interacciones()
+{
+    const Reloj::time_point inicio = Reloj::now();
+    const ModoDelSolver modo = m_configuracion.modo;
+
+    const int cantidad = m_store.cantidad();
+    if (!m_grafo.construido())
+        m_grafo.construir(cantidad);
+    if (modo == ModoDelSolver::Coloreado && !m_grafo.coloreado())
+        m_grafo.colorear(m_store.m_estatica);
+    if (m_epoca > UINT32_MAX / 2)
+    {
+        m_grafo.m_visita.assign(m_grafo.cantidad_aristas(), 0);
+        m_epoca = 0;
     }
 
-    for (Particula *particula : m_particulas)
-        particula->actualizar(m_dt);
+    m_estadisticas = {};
+    m_estadisticas.despertadas = m_despertadas_pendientes;
+    m_despertadas_pendientes = 0;
+
+    separar_en_islas();
+    despertar_islas();
+    m_estadisticas.aristas_activas = contar_aristas_activas();
+
+    if (modo == ModoDelSolver::Islas)
+        resolver_islas(inicio);
+    if (modo == ModoDelSolver::Ordenado)
+        m_grafo.ordenar_por_soporte(m_store.m_estatica);
+
+    float residuo = .0f;
+    bool listo = modo == ModoDelSolver::Islas;
+    while (!listo)
+    {
+        if (modo == ModoDelSolver::Coloreado)
+            residuo = expandir_por_colores();
+        else if (modo == ModoDelSolver::Ordenado)
+            residuo = expandir_ordenado();
+        else
+            residuo = expandir_en_serie();
+
+        m_store.actualizar_propiedades();
+        m_estadisticas.pasadas++;
+        listo = terminado(residuo, m_estadisticas.pasadas, inicio);
+    }
+
+    if (modo != ModoDelSolver::Islas)
+    {
+        m_estadisticas.residuo = std::sqrt(residuo);
+        m_estadisticas.convergio = residuo <= m_configuracion.tolerancia * m_configuracion.tolerancia;
+    }
+
+    m_store.integrar(m_dt);
+    actualizar_sueno();
+    publicar();
+
+    m_estadisticas.tiempo = Reloj::now() - inicio;
+    return m_estadisticas;
 }
 
-Particula::Particula(float masa, Vector2 velocidad, Vector2 fuerza, float coeficiente)
-    : m_velocidad(velocidad), m_fuerza(fuerza), m_masa(masa), m_coeficiente(coeficiente), m_estatica(false),
-      m_velocidad_guardada(velocidad), m_fuerza_guardada(fuerza)
+bool Sistema::dormida(Particula *particula) const
 {
+    return m_store.m_dormida[particula->m_indice];
 }
 
-Particula::Particula()
-    : m_estatica(true)
+const Estadisticas &Sistema::estadisticas() const
 {
+    return m_estadisticas;
 }
 
-Particula::~Particula()
+const ConfiguracionDelSolver &Sistema::configuracion() const
 {
-    for (Interaccion *interaccion : m_interacciones)
-        delete interaccion;
+    return m_configuracion;
 }
 
-void Particula::agregar_interaccion(Particula *referencia, Vector2 &direccion, float dt)
+const ParticleStore &Sistema::store() const
 {
-    for (Interaccion *interaccion : m_interacciones)
-        if (interaccion->m_particula == referencia)
-            return;
+    return m_store;
+}
 
-    Interaccion *interaccion = new Interaccion(referencia, direccion, dt);
-    m_interacciones.emplace_back(interaccion);
+const GrafoDeInteracciones &Sistema::grafo() const
+{
+    return m_grafo;
 }
 
-bool Particula::expandir()
+// Los residuos se llevan como el modulo al cuadrado del mayor impulso, y la
+// raiz se toma solo al publicar las estadisticas
+float Sistema::expandir_en_serie()
 {
-    if (m_fuerza.nulo() && m_velocidad.nulo())
-        return true;
+    const int cantidad = m_store.cantidad();
+    const uint32_t epoca = nueva_epoca();
+
+    float residuo = .0f;
+    for (int particula = 0; particula < cantidad; particula++)
+        residuo = std::max(residuo, expandir(particula, epoca));
+    return residuo;
+}
+
+// Primero se recorre de la particula mas alta a la mas baja, llevando el peso
+// hacia los soportes, y despues al reves, devolviendo las reacciones. Cada
+// interaccion se ve en el momento, por lo que una pila de cualquier altura
+// converge en una cantidad constante de pasadas
+float Sistema::expandir_ordenado()
+{
+    const std::vector<int> &orden = m_grafo.m_orden_por_altura;
+    const int cantidad = (int)orden.size();
+
+    float residuo = .0f;
+
+    const uint32_t bajada = nueva_epoca();
+    for (int i = 0; i < cantidad; i++)
+        residuo = std::max(residuo, expandir(orden[i], bajada, true));
+
+    const uint32_t subida = nueva_epoca();
+    for (int i = cantidad - 1; i >= 0; i--)
+        residuo = std::max(residuo, expandir(orden[i], subida, true));
+
+    return residuo;
+}
+
+// Las aristas de un mismo color no comparten particulas que se escriban, por
+// lo que se resuelven en paralelo sin carreras. Como en cada iteracion solo se
+// leen los valores de la iteracion anterior, el resultado es el mismo que en
+// serie salvo por el orden de las sumas
+float Sistema::expandir_por_colores()
+{
+    float residuo = .0f;
+
+    const int colores = m_grafo.cantidad_colores();
+    for (int color = 0; color < colores; color++)
+    {
+        const int inicio = m_grafo.m_desplazamientos_color[color];
+        const int fin = m_grafo.m_desplazamientos_color[color + 1];
+
+#pragma omp parallel for schedule(static) reduction(max : residuo)
+        for (int i = inicio; i < fin; i++)
+            residuo = std::max(residuo, expandir_contacto(m_grafo.m_aristas_por_color[i]));
+    }
+
+    return residuo;
+}
+
+// Las particulas estaticas que no se mueven son fronteras entre islas
+void Sistema::separar_en_islas()
+{
+    const int cantidad = m_store.cantidad();
+    m_fronteras.resize(cantidad);
+    for (int i = 0; i < cantidad; i++)
+        m_fronteras[i] = m_store.m_estatica[i] && m_store.nulo(i);
 
-    bool hay_interaccion = false;
+    m_grafo.separar_en_islas(m_fronteras);
+}
+
+// Las islas se reparten de mayor a menor entre los hilos, asi la mas grande
+// empieza primero y las chicas terminan sin esperar al resto
+void Sistema::resolver_islas(Reloj::time_point inicio)
+{
+    const int islas = m_grafo.cantidad_islas();
+    int pasadas = 0;
+    float residuo = .0f;
 
-    for (Interaccion *interaccion : m_interacciones)
-        hay_interaccion |= interaccion->expandir(this);
+#pragma omp parallel for schedule(dynamic, 1) reduction(max : pasadas, residuo)
+    for (int isla = 0; isla < islas; isla++)
+    {
+        if (isla_dormida(isla))
+            continue;
+        float residuo_isla = .0f;
+        pasadas = std::max(pasadas, resolver_isla(isla, inicio, residuo_isla));
+        residuo = std::max(residuo, residuo_isla);
+    }
 
-    return !hay_interaccion;
+    m_estadisticas.pasadas = pasadas;
+    m_estadisticas.residuo = std::sqrt(residuo);
+    m_estadisticas.convergio = residuo <= m_configuracion.tolerancia * m_configuracion.tolerancia;
 }
 
-void Particula::agregar_al_historial(Particula *particula)
+// El presupuesto es de todo el paso, por lo que las islas que empiezan tarde
+// pueden cortar despues de una sola iteracion
+int Sistema::resolver_isla(int isla, Reloj::time_point inicio, float &residuo)
 {
-    m_historial.emplace_back(particula);
+    const int desplazamiento = m_grafo.m_desplazamientos_isla[isla];
+    const int cantidad = m_grafo.m_desplazamientos_isla[isla + 1] - desplazamiento;
+    const int *particulas = m_grafo.m_particulas_por_isla.data() + desplazamiento;
+
+    int pasadas = 0;
+    bool listo = false;
+    while (!listo)
+    {
+        residuo = .0f;
+        const uint32_t epoca = nueva_epoca();
+        for (int j = 0; j < cantidad; j++)
+            residuo = std::max(residuo, expandir(particulas[j], epoca));
+
+        m_store.actualizar_propiedades(particulas, cantidad);
+        listo = terminado(residuo, ++pasadas, inicio);
+    }
+
+    return pasadas;
 }
 
-bool Particula::visitaste(Particula *particula)
+bool Sistema::terminado(float residuo, int pasadas, Reloj::time_point inicio) const
 {
-    for (Particula *p : m_historial)
-        if (p == particula)
-            return true;
-    return false;
+    if (residuo <= m_configuracion.tolerancia * m_configuracion.tolerancia)
+        return true;
+    if (pasadas >= m_configuracion.maximo_de_iteraciones)
+        return true;
+    return m_configuracion.presupuesto.count() > 0 && Reloj::now() - inicio >= m_configuracion.presupuesto;
 }
 
-void Particula::actualizar(float dt)
+// Una arista esta activa si alguno de sus extremos esta despierto y se mueve
+int Sistema::contar_aristas_activas() const
 {
-    if (!m_estatica)
-        m_velocidad += (m_fuerza * dt) / m_masa;
-    m_fuerza *= .0f;
+    const int aristas = m_grafo.cantidad_aristas();
+    int activas = 0;
+    for (int arista = 0; arista < aristas; arista++)
+    {
+        int a = m_grafo.m_a[arista], b = m_grafo.m_b[arista];
+        bool activa_a = !m_store.m_dormida[a] && !m_store.nulo(a);
+        bool activa_b = !m_store.m_dormida[b] && !m_store.nulo(b);
+        activas += activa_a || activa_b;
+    }
+    return activas;
 }
 
-void Particula::actualizar_propiedades()
+// Despues de despertar_islas, las islas estan completamente dormidas o
+// completamente despiertas
+bool Sistema::isla_dormida(int isla) const
 {
-    m_velocidad = m_velocidad_guardada;
-    m_fuerza = m_fuerza_guardada;
-    m_historial.clear();
+    int primera = m_grafo.m_particulas_por_isla[m_grafo.m_desplazamientos_isla[isla]];
+    return m_store.m_dormida[primera];
 }
 
-void Particula::velocidad_por_choque(Vector2 fuerza_choque)
+// Si una interaccion une particulas dormidas con otras despiertas, toda la
+// isla se despierta
+void Sistema::despertar_islas()
 {
-    if (!m_estatica)
-        m_velocidad_guardada += (fuerza_choque) / m_masa;
+    const int islas = m_grafo.cantidad_islas();
+    for (int isla = 0; isla < islas; isla++)
+    {
+        const int inicio = m_grafo.m_desplazamientos_isla[isla];
+        const int fin = m_grafo.m_desplazamientos_isla[isla + 1];
+
+        int dormidas = 0;
+        for (int i = inicio; i < fin; i++)
+            dormidas += m_store.m_dormida[m_grafo.m_particulas_por_isla[i]];
+
+        if (dormidas == 0 || dormidas == fin - inicio)
+            continue;
+
+        for (int i = inicio; i < fin; i++)
+            if (m_store.m_dormida[m_grafo.m_particulas_por_isla[i]])
+                m_store.despertar(m_grafo.m_particulas_por_isla[i]);
+        m_estadisticas.despertadas += dormidas;
+    }
 }
 
-void Particula::aplicar_fuerza(Vector2 fuerza)
+void Sistema::actualizar_sueno()
 {
-    if (!m_estatica)
-        m_fuerza_guardada += fuerza;
+    if (m_cuadros_de_sueno <= 0)
+        return;
+
+    const int cantidad = m_store.cantidad();
+    float umbral = m_velocidad_de_sueno * m_velocidad_de_sueno;
+    for (int i = 0; i < cantidad; i++)
+    {
+        if (m_store.m_estatica[i] || m_store.m_dormida[i])
+            continue;
+        bool quieta = m_store.velocidad(i).modulo_cuadrado() < umbral;
+        m_store.m_cuadros_quieta[i] = quieta ? m_store.m_cuadros_quieta[i] + 1 : 0;
+    }
+
+    const int islas = m_grafo.cantidad_islas();
+    for (int isla = 0; isla < islas; isla++)
+    {
+        if (isla_dormida(isla))
+            continue;
+
+        const int inicio = m_grafo.m_desplazamientos_isla[isla];
+        const int fin = m_grafo.m_desplazamientos_isla[isla + 1];
+
+        bool quieta = true;
+        for (int i = inicio; i < fin && quieta; i++)
+            quieta = m_store.m_cuadros_quieta[m_grafo.m_particulas_por_isla[i]] >= m_cuadros_de_sueno;
+
+        if (!quieta)
+            continue;
+
+        for (int i = inicio; i < fin; i++)
+            m_store.dormir(m_grafo.m_particulas_por_isla[i]);
+        m_estadisticas.dormidas += fin - inicio;
+    }
+
+    for (int i = 0; i < cantidad; i++)
+    {
+        bool sola = m_grafo.m_isla[i] < 0 && !m_store.m_estatica[i];
+        if (sola && !m_store.m_dormida[i] && m_store.m_cuadros_quieta[i] >= m_cuadros_de_sueno)
+        {
+            m_store.dormir(i);
+            m_estadisticas.dormidas++;
+        }
+        m_estadisticas.total_dormidas += m_store.m_dormida[i];
+    }
 }
 
-Interaccion::Interaccion(Particula *particula, Vector2 &direccion, float dt)
-    : m_particula(particula), m_direccion(direccion), m_dt(dt)
+// Cada iteracion (de todo el sistema o de una isla) toma una epoca distinta,
+// y una arista ya tuvo interaccion en la iteracion si su visita es esa epoca,
+// por lo que no hace falta limpiar nada entre iteraciones
+uint32_t Sistema::nueva_epoca()
 {
+    return ++m_epoca;
 }
 
-Vector2 fuerza_de_choque(Particula *particula, Particula *referencia, Vector2 &direccion)
+float Sistema::expandir(int particula, uint32_t epoca, bool sincronizar)
 {
-    float masa1 = particula->m_masa;
-    float masa2 = (referencia->m_estatica) ? masa1 : referencia->m_masa;
+    if (m_store.m_dormida[particula] || m_store.nulo(particula))
+        return .0f;
 
-    float coeficiente1 = particula->m_coeficiente;
-    float coeficiente2 = (referencia->m_estatica) ? coeficiente1 : referencia->m_coeficiente;
+    float residuo = .0f;
+
+    const int fin = m_grafo.m_desplazamientos[particula + 1];
+    for (int i = m_grafo.m_desplazamientos[particula]; i < fin; i++)
+        residuo = std::max(residuo, expandir_arista(m_grafo.m_incidencias[i], particula, epoca, sincronizar));
+
+    return residuo;
+}
+
+void Sistema::publicar()
+{
+    const int cantidad = m_store.cantidad();
+    for (int i = 0; i < cantidad; i++)
+    {
+        m_particulas[i]->m_velocidad = m_store.velocidad(i);
+        m_particulas[i]->m_fuerza = m_store.fuerza(i);
+    }
+}
+
+Particula::Particula(float masa, Vector2 velocidad, Vector2 fuerza, float coeficiente)
+    : m_velocidad(velocidad), m_fuerza(fuerza), m_masa(masa), m_coeficiente(coeficiente), m_estatica(false),
+      m_indice(-1)
+{
+}
+
+Particula::Particula()
+    : m_masa(.0f), m_coeficiente(.0f), m_estatica(true), m_indice(-1)
+{
+}
+
+Vector2 fuerza_de_choque(ParticleStore &store, int particula, int referencia, Vector2 &direccion)
+{
+    bool referencia_estatica = store.m_estatica[referencia];
+
+    float masa1 = store.m_masa[particula];
+    float masa2 = (referencia_estatica) ? masa1 : store.m_masa[referencia];
+
+    float coeficiente1 = store.m_coeficiente[particula];
+    float coeficiente2 = (referencia_estatica) ? coeficiente1 : store.m_coeficiente[referencia];
 
     float coeficiente = (coeficiente1 + coeficiente2) / 4.0f + .5f;
 
-    Vector2 velocidad_de_choque = particula->m_velocidad.proyeccion(direccion) - referencia->m_velocidad.proyeccion(direccion);
+    Vector2 velocidad_de_choque = store.velocidad(particula).proyeccion(direccion) - store.velocidad(referencia).proyeccion(direccion);
     float promedio_de_masas = (masa1 + masa2) / 2.0f;
 
     Vector2 fuerza = (velocidad_de_choque * masa1 * masa2) / (promedio_de_masas);
 
-    return fuerza * coeficiente * (referencia->m_estatica ? 2.0f : 1.0f);
+    return fuerza * coeficiente * (referencia_estatica ? 2.0f : 1.0f);
+}
+
+// Al sincronizar, el resultado de la interaccion se ve inmediatamente en vez
+// de en la proxima iteracion
+float Sistema::expandir_arista(int arista, int particula, uint32_t epoca, bool sincronizar)
+{
+    if (m_grafo.m_visita[arista] == epoca)
+        return .0f;
+
+    float impulso = resolver_arista(arista, particula);
+    bool hay_interaccion = impulso > .0f;
+    if (hay_interaccion)
+        m_grafo.m_visita[arista] = epoca;
+
+    if (hay_interaccion && sincronizar)
+    {
+        m_store.sincronizar(particula);
+        m_store.sincronizar(m_grafo.otra(arista, particula));
+    }
+
+    return impulso;
+}
+
+// Equivalente a recorrer la arista desde cada extremo en orden de indice: la
+// particula de menor indice la resuelve primero, y la otra solo si no hubo
+// interaccion
+float Sistema::expandir_contacto(int arista)
+{
+    int a = m_grafo.m_a[arista], b = m_grafo.m_b[arista];
+
+    float impulso = .0f;
+    if (!m_store.m_dormida[a] && !m_store.nulo(a))
+        impulso = resolver_arista(arista, a);
+    if (impulso == .0f && !m_store.m_dormida[b] && !m_store.nulo(b))
+        impulso = resolver_arista(arista, b);
+    return impulso;
 }
 
-bool Interaccion::expandir(Particula *particula)
+// Devuelve el modulo al cuadrado del mayor impulso transmitido, o cero si no
+// hubo interaccion
+float Sistema::resolver_arista(int arista, int particula)
 {
-    if (m_particula->visitaste(particula))
-        return false;
+    int referencia = m_grafo.otra(arista, particula);
 
-    Vector2 fuerza_resultante = particula->m_fuerza.proyeccion(m_direccion);
-    Vector2 fuerza_choque = fuerza_de_choque(particula, m_particula, m_direccion);
+    Vector2 direccion = m_grafo.direccion(arista, particula);
+    Vector2 fuerza_resultante = m_store.fuerza(particula).proyeccion(direccion);
+    Vector2 fuerza_choque = fuerza_de_choque(m_store, particula, referencia, direccion);
 
-    bool hay_resultante = fuerza_resultante * m_direccion > 0;
-    bool hay_choque = fuerza_choque * m_direccion > 0 && particula->m_velocidad * m_direccion > 0;
+    bool hay_resultante = fuerza_resultante * direccion > 0;
+    bool hay_choque = fuerza_choque * direccion > 0 && m_store.velocidad(particula) * direccion > 0;
 
     if (hay_choque)
     {
-        m_particula->velocidad_por_choque(fuerza_choque);
-        particula->velocidad_por_choque(fuerza_choque * -1.0f);
+        m_store.velocidad_por_choque(referencia, fuerza_choque);
+        m_store.velocidad_por_choque(particula, fuerza_choque * -1.0f);
     }
 
     if (hay_resultante)
     {
-        m_particula->aplicar_fuerza(fuerza_resultante);
-        particula->aplicar_fuerza(fuerza_resultante * -1.0f);
+        m_store.aplicar_fuerza(referencia, fuerza_resultante);
+        m_store.aplicar_fuerza(particula, fuerza_resultante * -1.0f);
     }
 
-    if (hay_resultante || hay_choque)
-        particula->agregar_al_historial(m_particula);
-
-    return hay_resultante || hay_choque;
+    float impulso = .0f;
+    if (hay_choque)
+        impulso = fuerza_choque.modulo_cuadrado();
+    if (hay_resultante)
+        impulso = std::max(impulso, fuerza_resultante.modulo_cuadrado());
+    if (hay_choque || hay_resultante)
+        impulso = std::max(impulso, std::numeric_limits<float>::min());
+    return impulso;
 }
@@ -1,25 +1,102 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <chrono>
 
 #include "vector.h"
+#include "particleStore.h"
+#include "grafoDeInteracciones.h"
 
 namespace sistema
 {
     class Particula;
-    class Interaccion;
+
+    enum class ModoDelSolver
+    {
+        Serial,
+        Coloreado, // cada color del grafo se resuelve en paralelo
+        Islas,     // cada isla converge por separado y en paralelo
+        Ordenado   // barridos de arriba hacia los soportes y de vuelta
+    };
+
+    struct ConfiguracionDelSolver
+    {
+        ModoDelSolver modo = ModoDelSolver::Islas;
+        float tolerancia = .0f; // residuo con el que se considera que convergio
+        int maximo_de_iteraciones = 10;
+        std::chrono::nanoseconds presupuesto{0}; // tiempo maximo por paso, 0 es sin limite
+    };
+
+    struct Estadisticas
+    {
+        int dormidas;    // particulas que se durmieron en el paso
+        int despertadas; // particulas que se despertaron en el paso
+        int total_dormidas;
+        int pasadas; // iteraciones usadas (la mayor entre todas las islas)
+        float residuo; // mayor impulso de la ultima iteracion
+        bool convergio;
+        int aristas_activas;
+        std::chrono::nanoseconds tiempo;
+    };
 
     class Sistema
     {
     private:
         std::vector<Particula *> m_particulas;
+        ParticleStore m_store;
+        GrafoDeInteracciones m_grafo;
+        std::vector<uint8_t> m_fronteras;
+        std::atomic<uint32_t> m_epoca;
+        ConfiguracionDelSolver m_configuracion;
         float m_dt;
 
+        float m_velocidad_de_sueno;
+        int m_cuadros_de_sueno;
+        int m_despertadas_pendientes;
+        Estadisticas m_estadisticas;
+
     public:
         Sistema(std::vector<Particula *> &particulas, float dt);
 
         void agregar_interaccion(Particula *particula, Particula *referencia, Vector2 &direccion);
-        void expandir_interacciones();
+        void agregar_interaccion(int particula, int referencia, Vector2 direccion);
+        void limpiar_interacciones();
+        void aplicar_fuerza(Particula *particula, Vector2 fuerza);
+        void aplicar_gravedad(Vector2 gravedad);
+        void usar_modo(ModoDelSolver modo);
+        void configurar_solver(const ConfiguracionDelSolver &configuracion);
+        void configurar_sueno(float velocidad_minima, int cuadros);
+        Estadisticas expandir_interacciones();
+
+        bool dormida(Particula *particula) const;
+        const Estadisticas &estadisticas() const;
+        const ConfiguracionDelSolver &configuracion() const;
+        const ParticleStore &store() const;
+        const GrafoDeInteracciones &grafo() const;
+
+    private:
+        using Reloj = std::chrono::steady_clock;
+
+        float expandir_en_serie();
+        float expandir_por_colores();
+        float expandir_ordenado();
+        void separar_en_islas();
+        void resolver_islas(Reloj::time_point inicio);
+        int resolver_isla(int isla, Reloj::time_point inicio, float &residuo);
+        bool terminado(float residuo, int pasadas, Reloj::time_point inicio) const;
+        int contar_aristas_activas() const;
+
+        bool isla_dormida(int isla) const;
+        void despertar_islas();
+        void actualizar_sueno();
+
+        uint32_t nueva_epoca();
+        float expandir(int particula, uint32_t epoca, bool sincronizar = false);
+        float expandir_arista(int arista, int particula, uint32_t epoca, bool sincronizar);
+        float expandir_contacto(int arista);
+        float resolver_arista(int arista, int particula);
+        void publicar();
     };
 
     class Particula
@@ -28,41 +105,11 @@ namespace sistema
         Vector2 m_velocidad, m_fuerza;
         float m_masa, m_coeficiente;
         bool m_estatica;
-        std::vector<Interaccion *> m_interacciones;
-
-    private:
-        Vector2 m_velocidad_guardada, m_fuerza_guardada;
-        std::vector<Particula *> m_historial;
+        int m_indice;
 
     public:
         Particula(float masa, Vector2 velocidad, Vector2 fuerza, float coeficiente);
         Particula(); // estatica
-        ~Particula();
-
-        void agregar_interaccion(Particula *referencia, Vector2 &direccion, float dt);
-        bool expandir();
-
-        void agregar_al_historial(Particula *particula);
-        bool visitaste(Particula *particula);
-
-        void actualizar(float dt);
-        void actualizar_propiedades();
-
-        void velocidad_por_choque(Vector2 fuerza_choque);
-        void aplicar_fuerza(Vector2 fuerza);
-    };
-
-    class Interaccion
-    {
-    public:
-        Particula *m_particula;
-        Vector2 m_direccion;
-        float m_dt;
-
-    public:
-        Interaccion(Particula *particula, Vector2 &direccion, float dt);
-
-        bool expandir(Particula *particula);
     };
 
 }
\ No newline at end of file
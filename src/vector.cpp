@@ -1,99 +1,137 @@
 #include "vector.h"
 
-#include <math.h>
+#include <limits>
 
-Vector2::Vector2() : x(.0f), y(.0f) {}
-
-Vector2::Vector2(float x, float y) : x(x), y(y) {}
-
-Vector2 Vector2::operator+(const Vector2 &otro) const
+Vector2Batch::Vector2Batch(int cantidad)
+    : m_x(cantidad, .0f), m_y(cantidad, .0f)
 {
-    return Vector2(x + otro.x, y + otro.y);
 }
 
-Vector2 Vector2::operator-(const Vector2 &otro) const
+void Vector2Batch::agregar(Vector2 vector)
 {
-    return Vector2(x - otro.x, y - otro.y);
+    m_x.push_back(vector.x);
+    m_y.push_back(vector.y);
 }
 
-Vector2 Vector2::operator*(float alpha) const
+void Vector2Batch::reservar(int cantidad)
 {
-    return Vector2(x * alpha, y * alpha);
+    m_x.reserve(cantidad);
+    m_y.reserve(cantidad);
 }
 
-float Vector2::operator*(const Vector2 &otro) const
+void Vector2Batch::vaciar()
 {
-    return (x * otro.x + y * otro.y);
+    m_x.clear();
+    m_y.clear();
 }
 
-Vector2 Vector2::operator/(float alpha) const
+int Vector2Batch::cantidad() const
 {
-    return Vector2(x / alpha, y / alpha);
+    return (int)m_x.size();
 }
 
-void Vector2::operator+=(const Vector2 &otro)
+void Vector2Batch::asignar(int indice, Vector2 vector)
 {
-    x += otro.x;
-    y += otro.y;
+    m_x[indice] = vector.x;
+    m_y[indice] = vector.y;
 }
 
-void Vector2::operator-=(const Vector2 &otro)
+void Vector2Batch::operator+=(const Vector2Batch &otro)
 {
-    x -= otro.x;
-    y -= otro.y;
-}
+    const int n = cantidad();
+    float *x = m_x.data(), *y = m_y.data();
+    const float *otro_x = otro.m_x.data(), *otro_y = otro.m_y.data();
 
-void Vector2::operator*=(float alpha)
-{
-    *this = *this * alpha;
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        x[i] += otro_x[i];
+        y[i] += otro_y[i];
+    }
 }
 
-void Vector2::operator/=(float alpha)
+void Vector2Batch::operator-=(const Vector2Batch &otro)
 {
-    *this = *this / alpha;
+    const int n = cantidad();
+    float *x = m_x.data(), *y = m_y.data();
+    const float *otro_x = otro.m_x.data(), *otro_y = otro.m_y.data();
+
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        x[i] -= otro_x[i];
+        y[i] -= otro_y[i];
+    }
 }
 
-bool Vector2::operator==(const Vector2 &otro) const
+void Vector2Batch::operator+=(Vector2 vector)
 {
-    bool en_x = (this->x - delta < otro.x and otro.x < this->x + delta);
-    bool en_y = (this->y - delta < otro.y and otro.y < this->y + delta);
+    const int n = cantidad();
+    float *x = m_x.data(), *y = m_y.data();
 
-    return en_x && en_y;
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        x[i] += vector.x;
+        y[i] += vector.y;
+    }
 }
 
-float Vector2::modulo() const
+void Vector2Batch::operator*=(float alpha)
 {
-    return sqrt(pow(x, 2) + pow(y, 2));
-}
+    const int n = cantidad();
+    float *x = m_x.data(), *y = m_y.data();
 
-float Vector2::modulo_cuadrado() const
-{
-    return pow(x, 2) + pow(y, 2);
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        x[i] *= alpha;
+        y[i] *= alpha;
+    }
 }
 
-float Vector2::distancia(const Vector2 &otro) const
+void Vector2Batch::producto_escalar(const Vector2Batch &otro, float *resultado) const
 {
-    return (*this - otro).modulo();
-}
+    const int n = cantidad();
+    const float *x = m_x.data(), *y = m_y.data();
+    const float *otro_x = otro.m_x.data(), *otro_y = otro.m_y.data();
 
-float Vector2::distancia_cuadrada(const Vector2 &otro) const
-{
-    return pow(x - otro.x, 2) + pow(y - otro.y, 2);
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+        resultado[i] = x[i] * otro_x[i] + y[i] * otro_y[i];
 }
 
-Vector2 Vector2::proyeccion(const Vector2 &otro) const
+void Vector2Batch::proyeccion(const Vector2Batch &otro, Vector2Batch &resultado) const
 {
-    return otro * (((*this) * otro) / otro.modulo_cuadrado());
-}
+    const int n = cantidad();
+    resultado.m_x.resize(n);
+    resultado.m_y.resize(n);
+    const float *x = m_x.data(), *y = m_y.data();
+    const float *otro_x = otro.m_x.data(), *otro_y = otro.m_y.data();
+    float *resultado_x = resultado.m_x.data(), *resultado_y = resultado.m_y.data();
 
-Vector2 Vector2::normal() const
-{
-    if (this->modulo() == 0.0f)
-        return *this;
-    return (*this / this->modulo());
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        float escala = (x[i] * otro_x[i] + y[i] * otro_y[i]) / (otro_x[i] * otro_x[i] + otro_y[i] * otro_y[i]);
+        resultado_x[i] = otro_x[i] * escala;
+        resultado_y[i] = otro_y[i] * escala;
+    }
 }
 
-bool Vector2::nulo() const
+// Los nulos no se saltean: con el menor float sumado al modulo cuadrado
+// quedan multiplicados por un numero finito, y asi el bucle no tiene ramas
+// y se puede vectorizar
+void Vector2Batch::normalizar()
 {
-    return (*this == *this * .0f);
-}
\ No newline at end of file
+    const int n = cantidad();
+    float *x = m_x.data(), *y = m_y.data();
+
+#pragma omp simd
+    for (int i = 0; i < n; i++)
+    {
+        float inversa = 1.0f / std::sqrt(x[i] * x[i] + y[i] * y[i] + std::numeric_limits<float>::min());
+        x[i] *= inversa;
+        y[i] *= inversa;
+    }
+}
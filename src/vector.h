@@ -1,38 +1,104 @@
 #pragma once
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
-const float delta = 0.01f;
+constexpr float delta = 0.01f;
 
+// Todas las operaciones estan en el header para que se puedan inlinear en
+// cualquier unidad de compilacion, ya que se usan en todos los bucles
 struct Vector2
 {
     float x, y;
 
-    Vector2();
+    constexpr Vector2() : x(.0f), y(.0f) {}
 
-    Vector2(float x, float y);
+    constexpr Vector2(float x, float y) : x(x), y(y) {}
 
-    Vector2 operator+(const Vector2 &otro) const;
-    Vector2 operator-(const Vector2 &otro) const;
-    float operator*(const Vector2 &otro) const; // producto escalar
-    Vector2 operator*(float alpha) const;
-    Vector2 operator/(float alpha) const;
+    constexpr Vector2 operator+(const Vector2 &otro) const { return Vector2(x + otro.x, y + otro.y); }
+    constexpr Vector2 operator-(const Vector2 &otro) const { return Vector2(x - otro.x, y - otro.y); }
+    constexpr float operator*(const Vector2 &otro) const { return x * otro.x + y * otro.y; } // producto escalar
+    constexpr Vector2 operator*(float alpha) const { return Vector2(x * alpha, y * alpha); }
+    constexpr Vector2 operator/(float alpha) const { return Vector2(x / alpha, y / alpha); }
 
-    void operator+=(const Vector2 &otro);
-    void operator-=(const Vector2 &otro);
-    void operator*=(float alpha);
-    void operator/=(float alpha);
+    constexpr void operator+=(const Vector2 &otro)
+    {
+        x += otro.x;
+        y += otro.y;
+    }
+
+    constexpr void operator-=(const Vector2 &otro)
+    {
+        x -= otro.x;
+        y -= otro.y;
+    }
+
+    constexpr void operator*=(float alpha) { *this = *this * alpha; }
+    constexpr void operator/=(float alpha) { *this = *this / alpha; }
+
+    constexpr bool operator==(const Vector2 &otro) const
+    {
+        bool en_x = (this->x - delta < otro.x and otro.x < this->x + delta);
+        bool en_y = (this->y - delta < otro.y and otro.y < this->y + delta);
+
+        return en_x && en_y;
+    }
+
+    float modulo() const { return std::sqrt(modulo_cuadrado()); }
+    constexpr float modulo_cuadrado() const { return x * x + y * y; }
+
+    float distancia(const Vector2 &otro) const { return (*this - otro).modulo(); }
+    constexpr float distancia_cuadrada(const Vector2 &otro) const { return (*this - otro).modulo_cuadrado(); }
+
+    constexpr Vector2 proyeccion(const Vector2 &otro) const
+    {
+        return otro * (((*this) * otro) / otro.modulo_cuadrado());
+    }
 
-    bool operator==(const Vector2 &otro) const;
+    Vector2 normal() const
+    {
+        float modulo = this->modulo();
+        if (modulo == 0.0f)
+            return *this;
+        return (*this / modulo);
+    }
 
-    float modulo() const;
-    float modulo_cuadrado() const;
+    constexpr bool nulo() const { return (*this == *this * .0f); }
+};
+
+// Muchos vectores con cada componente en su propio arreglo (structure of
+// arrays), para hacer la misma operacion sobre todos en un bucle vectorizado.
+// Las operaciones entre dos lotes van elemento a elemento, y los dos tienen
+// que tener la misma cantidad
+class Vector2Batch
+{
+public:
+    std::vector<float> m_x, m_y;
+
+public:
+    Vector2Batch() = default;
+    Vector2Batch(int cantidad);
+
+    void agregar(Vector2 vector);
+    void reservar(int cantidad);
+    void vaciar();
+    int cantidad() const;
+
+    Vector2 operator[](int indice) const { return Vector2(m_x[indice], m_y[indice]); }
+    void asignar(int indice, Vector2 vector);
+
+    void operator+=(const Vector2Batch &otro);
+    void operator-=(const Vector2Batch &otro);
+    void operator+=(Vector2 vector);
+    void operator*=(float alpha);
 
-    float distancia(const Vector2 &otro) const;
-    float distancia_cuadrada(const Vector2 &otro) const;
+    // Deja en resultado el producto escalar de cada par
+    void producto_escalar(const Vector2Batch &otro, float *resultado) const;
 
-    Vector2 proyeccion(const Vector2 &otro) const;
-    Vector2 normal() const;
+    // Deja en resultado cada vector proyectado en la direccion del otro
+    void proyeccion(const Vector2Batch &otro, Vector2Batch &resultado) const;
 
-    bool nulo() const;
-};
\ No newline at end of file
+    // Divide cada vector por su modulo, y deja igual a los nulos
+    void normalizar();
+};
@@ -0,0 +1,192 @@
+#include "gtest/gtest.h"
+#include "../src/arenaDeCuadro.h"
+#include "../src/quadtree.h"
+#include "../src/sistema.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Se reemplaza el operator new global para contar cuantas veces se pide
+// memoria al heap. Por eso estos tests van en su propio ejecutable
+static std::atomic<long> pedidos_al_heap(0);
+
+void *operator new(size_t bytes)
+{
+    pedidos_al_heap++;
+    if (void *memoria = std::malloc(bytes ? bytes : 1))
+        return memoria;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memoria) noexcept
+{
+    std::free(memoria);
+}
+
+void operator delete(void *memoria, size_t) noexcept
+{
+    std::free(memoria);
+}
+
+void *operator new(size_t bytes, std::align_val_t alineacion)
+{
+    pedidos_al_heap++;
+    size_t tamanio = ((bytes ? bytes : 1) + (size_t)alineacion - 1) & ~((size_t)alineacion - 1);
+    if (void *memoria = std::aligned_alloc((size_t)alineacion, tamanio))
+        return memoria;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memoria, std::align_val_t) noexcept
+{
+    std::free(memoria);
+}
+
+void operator delete(void *memoria, size_t, std::align_val_t) noexcept
+{
+    std::free(memoria);
+}
+
+class EntidadDeArena : public qt::Entidad
+{
+public:
+    Circulo m_cuerpo;
+
+public:
+    EntidadDeArena(Vector2 posicion, float radio)
+        : m_cuerpo(posicion, radio)
+    {
+    }
+
+    bool colisiona(CuerpoRigido *area)
+    {
+        return m_cuerpo.intersecta(area);
+    }
+
+    AABB limites()
+    {
+        return m_cuerpo.limites();
+    }
+};
+
+TEST(ArenaDeCuadroTest, Lo_pedido_queda_alineado_y_al_reiniciar_se_reutiliza)
+{
+    ArenaDeCuadro arena(256);
+
+    void *primero = arena.allocate(3, 1);
+    void *segundo = arena.allocate(8, 8);
+    ASSERT_EQ((size_t)segundo % 8, 0);
+    ASSERT_EQ(arena.usado(), 16);
+
+    arena.reiniciar();
+    ASSERT_EQ(arena.usado(), 0);
+    ASSERT_EQ(arena.allocate(3, 1), primero);
+}
+
+TEST(ArenaDeCuadroTest, Las_alineaciones_mayores_a_las_de_new_tambien_se_respetan)
+{
+    ArenaDeCuadro arena(512);
+
+    for (size_t alineacion : {32, 64, 128})
+    {
+        ASSERT_NE(arena.allocate(1, 1), nullptr);
+        void *alineado = arena.allocate(8, alineacion);
+        ASSERT_EQ((size_t)alineado % alineacion, 0);
+    }
+}
+
+TEST(ArenaDeCuadroTest, Si_un_cuadro_no_entra_el_buffer_crece_en_el_reinicio)
+{
+    ArenaDeCuadro arena(64);
+
+    void *primero = arena.allocate(48, 8);
+    void *segundo = arena.allocate(48, 8);
+    ASSERT_NE(primero, segundo);
+    ASSERT_EQ(arena.capacidad(), 64);
+
+    arena.reiniciar();
+    ASSERT_GE(arena.capacidad(), 96);
+
+    long antes = pedidos_al_heap;
+    primero = arena.allocate(48, 8);
+    segundo = arena.allocate(48, 8);
+    ASSERT_EQ(pedidos_al_heap - antes, 0);
+    ASSERT_EQ((std::byte *)segundo - (std::byte *)primero, 48);
+}
+
+TEST(ArenaDeCuadroTest, Un_paso_completo_estable_no_pide_memoria_al_heap)
+{
+    int filas = 4, columnas = 4;
+    std::vector<EntidadDeArena *> entidades;
+    std::vector<sistema::Particula *> particulas;
+    for (int i = 0; i < filas * columnas; i++)
+    {
+        Vector2 posicion(4.0f * (float)(i % columnas) - 6.0f, 4.0f * (float)(i / columnas) - 6.0f);
+        entidades.emplace_back(new EntidadDeArena(posicion, 1.0f));
+        particulas.emplace_back(new sistema::Particula(1.0f, Vector2(), Vector2(), .5f));
+    }
+    particulas.emplace_back(new sistema::Particula());
+
+    qt::QuadTree<EntidadDeArena> qt(Vector2(), 32.0f, 32.0f);
+    for (EntidadDeArena *entidad : entidades)
+        qt.insertar(entidad);
+
+    sistema::Sistema sistema(particulas, .1f);
+    sistema.configurar_sueno(.1f, 0);
+    ArenaDeCuadro arena;
+
+    // Un cuadro las entidades se amontonan en un cuadrante y al siguiente se
+    // separan, asi que cambian de hoja y el arbol se divide y se junta
+    float escalas[] = {1.0f, .5f};
+    int cuadro = 0;
+
+    auto paso = [&]()
+    {
+        arena.reiniciar();
+        cuadro++;
+        sistema.limpiar_interacciones();
+        sistema.aplicar_gravedad(Vector2(.0f, -9.8f));
+
+        for (int i = 0; i < filas * columnas; i++)
+        {
+            Vector2 posicion(4.0f * (float)(i % columnas) - 6.0f, 4.0f * (float)(i / columnas) - 6.0f);
+            entidades[i]->m_cuerpo.m_posicion = posicion * escalas[cuadro % 2] + Vector2(8.0f, 8.0f) * (float)(cuadro % 2);
+        }
+        qt.actualizar_lote(entidades, &arena);
+
+        for (int i = 0; i < filas * columnas; i++)
+        {
+            Circulo alcance(entidades[i]->m_cuerpo.m_posicion, 5.0f);
+            std::pmr::vector<EntidadDeArena *> vecinas(&arena);
+            qt.buscar(&alcance, vecinas);
+
+            if (i < columnas)
+                sistema.agregar_interaccion(i, filas * columnas, Vector2(.0f, -1.0f));
+            if (i + columnas < filas * columnas)
+                sistema.agregar_interaccion(i + columnas, i, Vector2(.0f, -1.0f));
+        }
+
+        sistema.expandir_interacciones();
+    };
+
+    for (int i = 0; i < 5; i++)
+        paso();
+
+    long antes = pedidos_al_heap;
+    int menos_nodos = qt.pool().vivos(), mas_nodos = qt.pool().vivos();
+    for (int i = 0; i < 20; i++)
+    {
+        paso();
+        menos_nodos = std::min(menos_nodos, qt.pool().vivos());
+        mas_nodos = std::max(mas_nodos, qt.pool().vivos());
+    }
+    ASSERT_EQ(pedidos_al_heap - antes, 0);
+    ASSERT_LT(menos_nodos, mas_nodos);
+
+    for (EntidadDeArena *entidad : entidades)
+        delete entidad;
+    for (sistema::Particula *particula : particulas)
+        delete particula;
+}
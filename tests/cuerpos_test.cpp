@@ -1,5 +1,9 @@
 #include "gtest/gtest.h"
 #include "../src/cuerpos/colisiones.h"
+#include "../src/cuerpos/contactos.h"
+#include "../src/cuerpos/formas.h"
+
+#include <random>
 
 TEST(CuerposTest, Colision_entre_circulo_y_aabb_en_rango)
 {
@@ -28,3 +32,222 @@ TEST(CuerposTest, Colision_entre_circulo_y_aabb_y_apenas_se_tocan_pero_no_es_val
     ASSERT_FALSE(punto_de_colision.colisiono);
 }
 
+TEST(CuerposTest, Intersecta_coincide_con_colisiona_donde_colisiona_es_exacto)
+{
+    AABB rect(Vector2(), 10.0f, 10.0f);
+    Circulo adentro(Vector2(), 10.0f), afuera(Vector2(100.0f, .0f), 10.0f), tocando(Vector2(20.0f, .0f), 10.0f);
+
+    ASSERT_TRUE(adentro.intersecta(&rect));
+    ASSERT_TRUE(rect.intersecta(&adentro));
+    ASSERT_FALSE(afuera.intersecta(&rect));
+
+    // A diferencia de colisiona, que apenas se toquen alcanza para descartar
+    ASSERT_TRUE(tocando.intersecta(&rect));
+
+    Circulo cerca(Vector2(15.0f, .0f), 6.0f);
+    ASSERT_TRUE(adentro.intersecta(&cerca));
+    ASSERT_FALSE(afuera.intersecta(&cerca));
+    ASSERT_EQ(adentro.intersecta(&cerca), adentro.colisiona(&cerca).colisiono);
+}
+
+TEST(CuerposTest, Intersecta_entre_circulo_y_aabb_es_exacto_en_las_esquinas)
+{
+    AABB rect(Vector2(), 10.0f, 10.0f);
+
+    // Sobre la diagonal, la esquina esta a raiz de 2 (1.41) de cada centro
+    Circulo toca_la_esquina(Vector2(11.0f, 11.0f), 1.5f);
+    Circulo no_llega(Vector2(11.0f, 11.0f), 1.3f);
+    Circulo de_costado(Vector2(14.0f, 10.5f), 4.1f);
+
+    ASSERT_TRUE(toca_la_esquina.intersecta(&rect));
+    ASSERT_FALSE(no_llega.intersecta(&rect));
+    ASSERT_TRUE(de_costado.intersecta(&rect));
+}
+
+TEST(CuerposTest, Intersecta_con_lineas)
+{
+    AABB rect(Vector2(), 10.0f, 10.0f);
+    Circulo circulo(Vector2(30.0f, .0f), 5.0f);
+
+    Linea cruza(Vector2(-20.0f, 1.0f), Vector2(40.0f, 2.0f));
+    Linea vertical(Vector2(5.0f, -20.0f), Vector2(5.0f, 20.0f));
+    Linea antes(Vector2(-40.0f, .0f), Vector2(-15.0f, .0f));
+    Linea pasa_por_arriba(Vector2(-20.0f, 12.0f), Vector2(40.0f, 12.0f));
+    Linea diagonal_de_lejos(Vector2(12.0f, -20.0f), Vector2(40.0f, 8.0f));
+
+    ASSERT_TRUE(cruza.intersecta(&rect));
+    ASSERT_TRUE(rect.intersecta(&cruza));
+    ASSERT_TRUE(vertical.intersecta(&rect));
+    ASSERT_FALSE(antes.intersecta(&rect));
+    ASSERT_FALSE(pasa_por_arriba.intersecta(&rect));
+    ASSERT_FALSE(diagonal_de_lejos.intersecta(&rect));
+
+    ASSERT_TRUE(cruza.intersecta(&circulo));
+    ASSERT_TRUE(circulo.intersecta(&cruza));
+    ASSERT_FALSE(antes.intersecta(&circulo));
+    ASSERT_FALSE(pasa_por_arriba.intersecta(&circulo));
+
+    ASSERT_TRUE(cruza.intersecta(&vertical));
+    ASSERT_FALSE(antes.intersecta(&vertical));
+}
+
+TEST(CuerposTest, Intersecta_entre_lineas_que_apenas_se_tocan)
+{
+    Linea horizontal(Vector2(-10.0f, .0f), Vector2(10.0f, .0f));
+
+    // Un extremo sobre la otra, en forma de T, y extremo con extremo
+    Linea en_t(Vector2(2.0f, .0f), Vector2(2.0f, 8.0f));
+    Linea en_el_extremo(Vector2(10.0f, .0f), Vector2(15.0f, 5.0f));
+    Linea casi_en_t(Vector2(2.0f, .5f), Vector2(2.0f, 8.0f));
+
+    ASSERT_TRUE(en_t.intersecta(&horizontal));
+    ASSERT_TRUE(horizontal.intersecta(&en_t));
+    ASSERT_TRUE(en_el_extremo.intersecta(&horizontal));
+    ASSERT_FALSE(casi_en_t.intersecta(&horizontal));
+
+    // Alineadas: se cortan solo si se superponen o se tocan en un extremo
+    Linea superpuesta(Vector2(5.0f, .0f), Vector2(20.0f, .0f));
+    Linea adentro(Vector2(-3.0f, .0f), Vector2(3.0f, .0f));
+    Linea a_continuacion(Vector2(10.0f, .0f), Vector2(20.0f, .0f));
+    Linea separada(Vector2(12.0f, .0f), Vector2(20.0f, .0f));
+    Linea paralela(Vector2(-10.0f, 1.0f), Vector2(10.0f, 1.0f));
+
+    ASSERT_TRUE(superpuesta.intersecta(&horizontal));
+    ASSERT_TRUE(horizontal.intersecta(&adentro));
+    ASSERT_TRUE(adentro.intersecta(&horizontal));
+    ASSERT_TRUE(a_continuacion.intersecta(&horizontal));
+    ASSERT_FALSE(separada.intersecta(&horizontal));
+    ASSERT_FALSE(paralela.intersecta(&horizontal));
+}
+
+static Forma forma_al_azar(std::mt19937 &generador)
+{
+    std::uniform_real_distribution<float> posicion(-30.0f, 30.0f), medida(1.0f, 15.0f);
+    Vector2 centro(posicion(generador), posicion(generador));
+
+    switch (generador() % 3)
+    {
+    case 0:
+        return Circulo(centro, medida(generador));
+    case 1:
+        return Linea(centro, Vector2(posicion(generador), posicion(generador)));
+    default:
+        return AABB(centro, medida(generador), medida(generador));
+    }
+}
+
+TEST(CuerposTest, Las_tablas_de_formas_coinciden_con_la_interfaz_virtual)
+{
+    std::mt19937 generador(23);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        Forma a = forma_al_azar(generador), b = forma_al_azar(generador);
+        auto [intersecta, punto] = std::visit([](auto &x, auto &y)
+                                              { return std::pair(x.intersecta(&y), x.colisiona(&y)); },
+                                              a, b);
+
+        ASSERT_EQ(colision::intersecta(a, b), intersecta);
+
+        PuntoDeColision tabla = colision::colisiona(a, b);
+        ASSERT_EQ(tabla.colisiono, punto.colisiono);
+        if (punto.colisiono)
+        {
+            ASSERT_FLOAT_EQ(tabla.normal.x, punto.normal.x);
+            ASSERT_FLOAT_EQ(tabla.normal.y, punto.normal.y);
+            ASSERT_FLOAT_EQ(tabla.distancia, punto.distancia);
+        }
+    }
+}
+
+TEST(CuerposTest, El_lote_de_pares_encuentra_los_mismos_pares_que_de_a_uno)
+{
+    std::mt19937 generador(7);
+    Formas formas;
+    std::vector<IdDeForma> ids;
+    for (int i = 0; i < 150; i++)
+        ids.push_back(formas.agregar(forma_al_azar(generador)));
+
+    LoteDePares lote;
+    std::vector<std::pair<IdDeForma, IdDeForma>> esperados;
+    for (size_t i = 0; i < ids.size(); i++)
+        for (size_t j = i + 1; j < ids.size(); j++)
+        {
+            lote.agregar(ids[i], ids[j]);
+            if (formas.cuerpo(ids[i])->intersecta(formas.cuerpo(ids[j])))
+                esperados.emplace_back(ids[i], ids[j]);
+        }
+    ASSERT_EQ(lote.cantidad(), (int)(ids.size() * (ids.size() - 1) / 2));
+
+    int encontrados = 0;
+    lote.intersecciones(formas, [&](IdDeForma a, IdDeForma b)
+                        {
+                            ASSERT_LE(a.tipo, b.tipo);
+                            bool esperado = std::find(esperados.begin(), esperados.end(), std::pair(a, b)) != esperados.end() ||
+                                            std::find(esperados.begin(), esperados.end(), std::pair(b, a)) != esperados.end();
+                            ASSERT_TRUE(esperado);
+                            encontrados++; });
+    ASSERT_EQ(encontrados, (int)esperados.size());
+
+    // Las colisiones vienen con la normal desde el primero hacia el segundo
+    lote.colisiones(formas, [&](IdDeForma a, IdDeForma b, PuntoDeColision punto)
+                    {
+                        Forma fa = formas.forma(a), fb = formas.forma(b);
+                        PuntoDeColision esperado = std::visit([](auto &x, auto &y)
+                                                              { return x.colisiona(&y); },
+                                                              fa, fb);
+                        ASSERT_TRUE(esperado.colisiono);
+                        ASSERT_FLOAT_EQ(punto.normal.x, esperado.normal.x);
+                        ASSERT_FLOAT_EQ(punto.normal.y, esperado.normal.y); });
+
+    lote.vaciar();
+    ASSERT_EQ(lote.cantidad(), 0);
+}
+
+TEST(CuerposTest, Colision_entre_circulos_con_los_puntos_en_los_bordes)
+{
+    Circulo a(Vector2(), 2.0f), b(Vector2(3.0f, .0f), 2.0f);
+    PuntoDeColision punto = a.colisiona(&b);
+
+    ASSERT_TRUE(punto.colisiono);
+    ASSERT_FLOAT_EQ(punto.A.x, 2.0f);
+    ASSERT_FLOAT_EQ(punto.B.x, 1.0f);
+    ASSERT_FLOAT_EQ(punto.distancia, 1.0f);
+    ASSERT_FLOAT_EQ(punto.normal.x, -1.0f);
+}
+
+TEST(CuerposTest, Las_colisiones_por_lote_entre_circulos_coinciden_con_de_a_una)
+{
+    std::mt19937 generador(24);
+    std::uniform_real_distribution<float> posicion(-20.0f, 20.0f), radio(.5f, 10.0f);
+
+    // Una cantidad que no llena el ultimo registro, para probar el resto
+    std::vector<Circulo> circulos;
+    colision::ParesDeCirculos pares;
+    for (int i = 0; i < 1003; i++)
+    {
+        circulos.emplace_back(Vector2(posicion(generador), posicion(generador)), radio(generador));
+        circulos.emplace_back(Vector2(posicion(generador), posicion(generador)), radio(generador));
+        pares.agregar(circulos[2 * i], circulos[2 * i + 1]);
+    }
+
+    for (auto instrucciones : {colision::Instrucciones::Escalar, colision::Instrucciones::SSE, colision::Instrucciones::AVX2})
+    {
+        colision::ContactosDeCirculos contactos;
+        colision::colisiones_circulo_circulo(pares, contactos, instrucciones);
+        ASSERT_EQ((int)contactos.colisiono.size(), pares.cantidad());
+
+        for (int i = 0; i < pares.cantidad(); i++)
+        {
+            PuntoDeColision punto = colision::colision_circulo_circulo(&circulos[2 * i], &circulos[2 * i + 1]);
+
+            ASSERT_EQ((bool)contactos.colisiono[i], punto.colisiono);
+            if (punto.colisiono)
+            {
+                ASSERT_NEAR(contactos.penetracion[i], punto.distancia, 1e-4f);
+            }
+            ASSERT_NEAR(contactos.normal_x[i], punto.normal.x, 1e-4f);
+            ASSERT_NEAR(contactos.normal_y[i], punto.normal.y, 1e-4f);
+        }
+    }
+}
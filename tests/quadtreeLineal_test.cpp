@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+#include "../src/quadtreeLineal.h"
+
+#include <algorithm>
+
+class EntidadLineal : public qt::Entidad
+{
+public:
+    Circulo m_cuerpo;
+
+public:
+    EntidadLineal(Vector2 posicion, float radio)
+        : m_cuerpo(posicion, radio)
+    {
+    }
+
+    bool colisiona(CuerpoRigido *area)
+    {
+        return m_cuerpo.intersecta(area);
+    }
+
+    AABB limites()
+    {
+        return m_cuerpo.limites();
+    }
+};
+
+TEST(QuadtreeLinealTest, Solo_se_insertan_las_entidades_en_rango)
+{
+    qt::QuadTreeLineal qt(Vector2(), 64.0f, 64.0f);
+    EntidadLineal adentro(Vector2(10.0f, -10.0f), 2.0f);
+    EntidadLineal afuera(Vector2(100.0f, 100.0f), 1.0f);
+
+    ASSERT_TRUE(qt.insertar(&adentro));
+    ASSERT_FALSE(qt.insertar(&afuera));
+    ASSERT_EQ(qt.cantidad(), 1);
+}
+
+TEST(QuadtreeLinealTest, Al_actualizar_una_entidad_se_encuentra_en_la_zona_nueva)
+{
+    AABB area(Vector2(), 64.0f, 64.0f);
+    qt::QuadTreeLineal qt(area);
+    EntidadLineal entidad(Vector2(), 5.0f);
+
+    qt.insertar(&entidad);
+    entidad.m_cuerpo.m_posicion = Vector2(40.0f, 40.0f);
+    qt.actualizar(&entidad);
+
+    AABB zona_nueva(Vector2(40.0f, 40.0f), 10.0f, 10.0f);
+    AABB zona_vieja(Vector2(-10.0f, -10.0f), 8.0f, 8.0f);
+
+    ASSERT_EQ(qt.buscar(&zona_nueva).size(), 1);
+    ASSERT_EQ(qt.buscar(&zona_vieja).size(), 0);
+}
+
+TEST(QuadtreeLinealTest, Al_eliminar_una_entidad_no_se_encuentra_mas)
+{
+    AABB area(Vector2(), 64.0f, 64.0f);
+    qt::QuadTreeLineal qt(area);
+    EntidadLineal entidad(Vector2(4.0f, 4.0f), 1.0f);
+
+    qt.insertar(&entidad);
+    ASSERT_EQ(qt.buscar(&area).size(), 1);
+
+    ASSERT_TRUE(qt.eliminar(&entidad));
+    ASSERT_FALSE(qt.eliminar(&entidad));
+    ASSERT_EQ(qt.buscar(&area).size(), 0);
+}
+
+TEST(QuadtreeLinealTest, Buscar_devuelve_lo_mismo_que_probar_todas_las_entidades)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTreeLineal qt(area);
+    std::vector<EntidadLineal *> entidades;
+
+    unsigned semilla = 7;
+    auto azar = [&semilla](float minimo, float maximo)
+    {
+        semilla = semilla * 1103515245u + 12345u;
+        return minimo + (maximo - minimo) * (float)((semilla >> 8) & 0xffff) / 65535.0f;
+    };
+
+    for (int i = 0; i < 300; i++)
+    {
+        entidades.emplace_back(new EntidadLineal(Vector2(azar(-120.0f, 120.0f), azar(-120.0f, 120.0f)), azar(.5f, 6.0f)));
+        qt.insertar(entidades.back());
+    }
+
+    for (int cuadro = 0; cuadro < 3; cuadro++)
+    {
+        for (int i = 0; i < 300; i += 3)
+        {
+            Vector2 &posicion = entidades[i]->m_cuerpo.m_posicion;
+            posicion.x = std::clamp(posicion.x + azar(-10.0f, 10.0f), -120.0f, 120.0f);
+            posicion.y = std::clamp(posicion.y + azar(-10.0f, 10.0f), -120.0f, 120.0f);
+            qt.actualizar(entidades[i]);
+        }
+
+        for (int consulta = 0; consulta < 20; consulta++)
+        {
+            Circulo region(Vector2(azar(-120.0f, 120.0f), azar(-120.0f, 120.0f)), azar(1.0f, 40.0f));
+
+            std::vector<qt::Entidad *> encontradas = qt.buscar(&region);
+            std::vector<qt::Entidad *> esperadas;
+            for (EntidadLineal *entidad : entidades)
+                if (entidad->colisiona(&region))
+                    esperadas.emplace_back(entidad);
+
+            std::sort(encontradas.begin(), encontradas.end());
+            std::sort(esperadas.begin(), esperadas.end());
+            ASSERT_EQ(encontradas, esperadas);
+        }
+    }
+
+    for (EntidadLineal *entidad : entidades)
+        delete entidad;
+}
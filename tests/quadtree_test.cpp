@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "../src/quadtree.h"
 
+#include <algorithm>
+
 class Entidad : public qt::Entidad
 {
 public:
@@ -14,7 +16,12 @@ public:
 
     bool colisiona(CuerpoRigido *area)
     {
-        return (m_cuerpo->colisiona(area).colisiono);
+        return m_cuerpo->intersecta(area);
+    }
+
+    AABB limites()
+    {
+        return m_cuerpo->limites();
     }
 };
 
@@ -254,3 +261,611 @@ TEST(QuadtreeTest, Varias_entidades_para_tener_una_subdivison_y_actualizo_una_pa
 
     ASSERT_EQ(buscar.size(), 1);
 }
+
+TEST(QuadtreeTest, Al_subdividir_los_hermanos_quedan_contiguos_en_el_pool)
+{
+    AABB area(Vector2(), 64.0f, 64.0f);
+    qt::QuadTree qt(area);
+    std::vector<Circulo *> cuerpos;
+    std::vector<Entidad *> entidades;
+
+    Vector2 posiciones[] = {Vector2(-32.0f, -32.0f), Vector2(32.0f, -32.0f), Vector2(-32.0f, 32.0f),
+                            Vector2(32.0f, 32.0f), Vector2(-40.0f, -40.0f)};
+    for (Vector2 posicion : posiciones)
+    {
+        Circulo *c = new Circulo(posicion, 1.0f);
+        Entidad *e = new Entidad(c);
+        qt.insertar(e);
+        entidades.emplace_back(e);
+        cuerpos.emplace_back(c);
+    }
+
+    ASSERT_EQ(qt.pool().vivos(), 4);
+
+    qt::Node *primero = entidades[0]->m_padres[0];
+    for (Entidad *e : entidades)
+    {
+        ASSERT_EQ(e->m_padres.size(), 1);
+        ptrdiff_t distancia = e->m_padres[0] - primero;
+        ASSERT_GE(distancia, -3);
+        ASSERT_LE(distancia, 3);
+    }
+
+    for (Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Al_juntar_los_nodos_vuelven_al_pool_y_se_reutilizan)
+{
+    AABB area(Vector2(), 64.0f, 64.0f);
+    qt::QuadTree qt(area);
+    std::vector<Circulo *> cuerpos;
+    std::vector<Entidad *> entidades;
+
+    for (float i = 0; i < 5.0f; i++)
+    {
+        Circulo *c = new Circulo(Vector2(4.0f, 4.0f + i * 8.0f), .0f);
+        entidades.emplace_back(new Entidad(c));
+        cuerpos.emplace_back(c);
+    }
+
+    int capacidad = 0;
+    for (int repeticion = 0; repeticion < 10; repeticion++)
+    {
+        for (Entidad *e : entidades)
+            qt.insertar(e);
+        ASSERT_GT(qt.pool().vivos(), 0);
+
+        for (Entidad *e : entidades)
+            qt.eliminar(e);
+        ASSERT_EQ(qt.pool().vivos(), 0);
+
+        for (Entidad *e : entidades)
+            ASSERT_EQ(e->m_padres.size(), 0);
+
+        if (repeticion == 0)
+            capacidad = qt.pool().capacidad();
+        ASSERT_EQ(qt.pool().capacidad(), capacidad);
+    }
+
+    ASSERT_GT(qt.pool().maximo(), 0);
+
+    for (Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+std::vector<Circulo *> crear_granos(int cantidad, float mitad, unsigned semilla)
+{
+    auto azar = [&semilla](float minimo, float maximo)
+    {
+        semilla = semilla * 1103515245u + 12345u;
+        return minimo + (maximo - minimo) * (float)((semilla >> 8) & 0xffff) / 65535.0f;
+    };
+
+    std::vector<Circulo *> cuerpos;
+    for (int i = 0; i < cantidad; i++)
+        cuerpos.emplace_back(new Circulo(Vector2(azar(-mitad, mitad), azar(-mitad, mitad)), azar(.5f, 4.0f)));
+    return cuerpos;
+}
+
+TEST(QuadtreeTest, Construir_en_lote_encuentra_lo_mismo_que_insertar_de_a_una)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree en_lote(area), de_a_una(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(2000, 120.0f, 3);
+    std::vector<Entidad *> entidades_lote, entidades_una;
+    std::vector<qt::Entidad *> lote;
+    for (Circulo *c : cuerpos)
+    {
+        entidades_lote.emplace_back(new Entidad(c));
+        entidades_una.emplace_back(new Entidad(c));
+        lote.emplace_back(entidades_lote.back());
+        de_a_una.insertar(entidades_una.back());
+    }
+
+    ASSERT_EQ(en_lote.construir(lote), 2000);
+    ASSERT_GT(en_lote.pool().vivos(), 0);
+    for (Entidad *e : entidades_lote)
+        ASSERT_GE(e->m_padres.size(), 1);
+
+    std::vector<Circulo *> regiones = crear_granos(30, 120.0f, 11);
+    for (Circulo *region : regiones)
+    {
+        region->m_radio *= 5.0f;
+        std::vector<CuerpoRigido *> encontrados_lote, encontrados_una;
+        for (qt::Entidad *e : en_lote.buscar(region))
+            encontrados_lote.emplace_back(((Entidad *)e)->m_cuerpo);
+        for (qt::Entidad *e : de_a_una.buscar(region))
+            encontrados_una.emplace_back(((Entidad *)e)->m_cuerpo);
+
+        std::sort(encontrados_lote.begin(), encontrados_lote.end());
+        std::sort(encontrados_una.begin(), encontrados_una.end());
+        ASSERT_EQ(encontrados_lote, encontrados_una);
+    }
+
+    for (Entidad *e : entidades_lote)
+        delete e;
+    for (Entidad *e : entidades_una)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+    for (Circulo *c : regiones)
+        delete c;
+}
+
+TEST(QuadtreeTest, Volver_a_construir_reemplaza_el_arbol_y_recicla_los_nodos)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(500, 120.0f, 5);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+
+    qt.construir(entidades);
+    int vivos = qt.pool().vivos();
+    std::vector<size_t> padres;
+    for (qt::Entidad *e : entidades)
+        padres.emplace_back(e->m_padres.size());
+
+    qt.construir(entidades);
+    ASSERT_EQ(qt.pool().vivos(), vivos);
+    ASSERT_EQ(qt.pool().maximo(), vivos);
+    for (size_t i = 0; i < entidades.size(); i++)
+        ASSERT_EQ(entidades[i]->m_padres.size(), padres[i]);
+    ASSERT_EQ(qt.buscar(&area).size(), entidades.size());
+
+    for (qt::Entidad *e : entidades)
+        qt.eliminar(e);
+    ASSERT_EQ(qt.pool().vivos(), 0);
+    for (qt::Entidad *e : entidades)
+        ASSERT_TRUE(e->m_padres.empty());
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Actualizar_en_lote_deja_cada_entidad_en_las_hojas_que_la_contienen)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 13);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    std::vector<Circulo *> desplazamientos = crear_granos(1000, 12.0f, 17);
+    for (int cuadro = 0; cuadro < 4; cuadro++)
+    {
+        for (size_t i = cuadro % 2; i < cuerpos.size(); i += 2)
+        {
+            Vector2 &posicion = cuerpos[i]->m_posicion;
+            posicion.x = std::clamp(posicion.x + desplazamientos[i]->m_posicion.x, -120.0f, 120.0f);
+            posicion.y = std::clamp(posicion.y + desplazamientos[i]->m_posicion.y, -120.0f, 120.0f);
+        }
+
+        // Una se va del area y despues vuelve
+        cuerpos[0]->m_posicion = cuadro % 2 == 0 ? Vector2(500.0f, 500.0f) : Vector2();
+        qt.actualizar_lote(entidades);
+
+        for (size_t i = 0; i < entidades.size(); i++)
+            ASSERT_EQ(entidades[i]->m_padres.empty(), !entidades[i]->colisiona(&area));
+
+        ASSERT_EQ(qt.buscar(&area).size(), entidades.size() - (cuadro % 2 == 0 ? 1 : 0));
+
+        // Cada entidad quedo en hojas que la contienen, por lo que se encuentra
+        // buscando con su propio cuerpo
+        for (size_t i = 1; i < entidades.size(); i++)
+        {
+            std::vector<qt::Entidad *> encontradas = qt.buscar(cuerpos[i]);
+            ASSERT_NE(std::find(encontradas.begin(), encontradas.end(), entidades[i]), encontradas.end());
+        }
+    }
+
+    for (qt::Entidad *e : entidades)
+        qt.eliminar(e);
+    ASSERT_EQ(qt.pool().vivos(), 0);
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+    for (Circulo *c : desplazamientos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Buscar_no_repite_entidades_aunque_esten_en_varias_hojas)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 23);
+    for (Circulo *c : cuerpos)
+        c->m_radio *= 3.0f;
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    std::vector<Circulo *> regiones = crear_granos(64, 100.0f, 29);
+    std::vector<std::vector<qt::Entidad *>> en_serie(regiones.size()), en_paralelo(regiones.size());
+    for (size_t i = 0; i < regiones.size(); i++)
+    {
+        regiones[i]->m_radio *= 10.0f;
+        en_serie[i] = qt.buscar(regiones[i]);
+        std::sort(en_serie[i].begin(), en_serie[i].end());
+        ASSERT_EQ(std::adjacent_find(en_serie[i].begin(), en_serie[i].end()), en_serie[i].end());
+    }
+
+    // Buscando desde varios hilos a la vez no se pierde ninguna entidad
+#pragma omp parallel for
+    for (int i = 0; i < (int)regiones.size(); i++)
+        en_paralelo[i] = qt.buscar(regiones[i]);
+
+    for (size_t i = 0; i < regiones.size(); i++)
+    {
+        std::sort(en_paralelo[i].begin(), en_paralelo[i].end());
+        en_paralelo[i].erase(std::unique(en_paralelo[i].begin(), en_paralelo[i].end()), en_paralelo[i].end());
+        ASSERT_EQ(en_paralelo[i], en_serie[i]);
+    }
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+    for (Circulo *c : regiones)
+        delete c;
+}
+
+TEST(QuadtreeTest, Pares_en_colision_da_cada_par_una_sola_vez)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1500, 120.0f, 31);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    using Par = std::pair<qt::Entidad *, qt::Entidad *>;
+    std::vector<Par> candidatos;
+    qt.pares_en_colision([&candidatos](qt::Entidad *a, qt::Entidad *b)
+                         {
+#pragma omp critical
+                             candidatos.emplace_back(std::min(a, b), std::max(a, b)); });
+
+    std::sort(candidatos.begin(), candidatos.end());
+    ASSERT_EQ(std::adjacent_find(candidatos.begin(), candidatos.end()), candidatos.end());
+
+    // Los candidatos solo tienen los limites superpuestos, por lo que falta
+    // probar si los cuerpos realmente colisionan
+    std::vector<Par> encontrados;
+    for (Par par : candidatos)
+        if (par.first->colisiona(((Entidad *)par.second)->m_cuerpo))
+            encontrados.emplace_back(par);
+
+    // Todos los pares que colisionan, probando cada par
+    std::vector<Par> esperados;
+    for (size_t i = 0; i < entidades.size(); i++)
+        for (size_t j = i + 1; j < entidades.size(); j++)
+            if (entidades[i]->colisiona(cuerpos[j]))
+                esperados.emplace_back(std::min(entidades[i], entidades[j]), std::max(entidades[i], entidades[j]));
+    std::sort(esperados.begin(), esperados.end());
+
+    ASSERT_GT(esperados.size(), 0);
+    ASSERT_EQ(encontrados, esperados);
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Buscar_con_un_visitante_encuentra_lo_mismo_y_puede_cortar_antes)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 37);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    Circulo region(Vector2(10.0f, -20.0f), 50.0f);
+    std::vector<qt::Entidad *> esperadas = qt.buscar(&region);
+    ASSERT_GT(esperadas.size(), 1);
+
+    std::vector<qt::Entidad *> visitadas;
+    ASSERT_TRUE(qt.buscar(&region, [&visitadas](qt::Entidad *e)
+                          { visitadas.emplace_back(e); }));
+    ASSERT_EQ(visitadas, esperadas);
+
+    int contadas = 0;
+    ASSERT_FALSE(qt.buscar(&region, [&contadas](qt::Entidad *)
+                           { return ++contadas < 3; }));
+    ASSERT_EQ(contadas, 3);
+
+    std::vector<qt::Entidad *> generadas;
+    for (qt::Entidad *e : qt.entidades_en(&region))
+        generadas.emplace_back(e);
+    std::sort(generadas.begin(), generadas.end());
+    std::sort(esperadas.begin(), esperadas.end());
+    ASSERT_EQ(generadas, esperadas);
+
+    for (qt::Entidad *e : qt.entidades_en(&region))
+    {
+        ASSERT_NE(std::find(esperadas.begin(), esperadas.end(), e), esperadas.end());
+        break;
+    }
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Se_puede_buscar_desde_el_visitante_sin_repetir_entidades)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 39);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    Circulo region(Vector2(-15.0f, 25.0f), 60.0f);
+    std::vector<qt::Entidad *> esperadas = qt.buscar(&region);
+    ASSERT_TRUE(std::any_of(esperadas.begin(), esperadas.end(), [](qt::Entidad *e)
+                            { return e->m_padres.size() > 1; }));
+
+    // Los vecinos de cada una, buscados en el mismo arbol mientras se recorre
+    std::vector<qt::Entidad *> visitadas;
+    int vecinos = 0;
+    qt.buscar(&region, [&](qt::Entidad *e)
+              {
+                  visitadas.emplace_back(e);
+                  vecinos += (int)qt.buscar_radio(e->limites().m_posicion, 10.0f).size();
+                  vecinos += (int)qt.k_vecinos(e->limites().m_posicion, 3).size(); });
+    ASSERT_EQ(visitadas, esperadas);
+    ASSERT_GT(vecinos, 0);
+
+    std::vector<qt::Entidad *> generadas;
+    for (qt::Entidad *e : qt.entidades_en(&region))
+    {
+        generadas.emplace_back(e);
+        Circulo alrededor(e->limites().m_posicion, 10.0f);
+        qt.buscar(&alrededor);
+    }
+    std::sort(generadas.begin(), generadas.end());
+    std::sort(esperadas.begin(), esperadas.end());
+    ASSERT_EQ(generadas, esperadas);
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Buscar_radio_y_k_vecinos_devuelven_las_mas_cercanas_en_orden)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 41);
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : cuerpos)
+        entidades.emplace_back(new Entidad(c));
+    qt.construir(entidades);
+
+    std::vector<Circulo *> centros = crear_granos(20, 120.0f, 43);
+    for (Circulo *c : centros)
+    {
+        Vector2 centro = c->m_posicion;
+        std::vector<qt::Entidad *> ordenadas = entidades;
+        std::sort(ordenadas.begin(), ordenadas.end(), [centro](qt::Entidad *a, qt::Entidad *b)
+                  { return centro.distancia_cuadrada(a->limites().m_posicion) < centro.distancia_cuadrada(b->limites().m_posicion); });
+
+        std::vector<qt::Entidad *> vecinos = qt.k_vecinos(centro, 7);
+        ASSERT_EQ(vecinos, std::vector<qt::Entidad *>(ordenadas.begin(), ordenadas.begin() + 7));
+
+        float radio = 5.0f * c->m_radio;
+        std::vector<qt::Entidad *> en_radio;
+        for (qt::Entidad *e : ordenadas)
+            if (centro.distancia_cuadrada(e->limites().m_posicion) <= radio * radio)
+                en_radio.emplace_back(e);
+        ASSERT_EQ(qt.buscar_radio(centro, radio), en_radio);
+    }
+
+    ASSERT_EQ(qt.k_vecinos(Vector2(), 5000).size(), entidades.size());
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (Circulo *c : cuerpos)
+        delete c;
+    for (Circulo *c : centros)
+        delete c;
+}
+
+TEST(QuadtreeTest, Raycast_devuelve_el_impacto_mas_cercano)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree qt(area);
+
+    std::vector<Circulo *> granos = crear_granos(500, 120.0f, 47);
+    std::vector<AABB *> cajas;
+    std::vector<qt::Entidad *> entidades;
+    for (Circulo *c : granos)
+    {
+        cajas.emplace_back(new AABB(c->m_posicion, c->m_radio, .5f * c->m_radio));
+        entidades.emplace_back(new Entidad(cajas.back()));
+    }
+    qt.construir(entidades);
+
+    std::vector<Circulo *> rayos = crear_granos(50, 120.0f, 53);
+    int impactos = 0;
+    for (size_t i = 0; i + 1 < rayos.size(); i += 2)
+    {
+        Vector2 origen = rayos[i]->m_posicion;
+        Vector2 direccion = rayos[i + 1]->m_posicion - origen;
+
+        qt::Entidad *esperada = nullptr;
+        float t_esperado = 1.0f;
+        Linea segmento(origen, origen + direccion);
+        for (qt::Entidad *e : entidades)
+        {
+            PuntoDeColision punto = e->cortar(&segmento);
+            float t = ((punto.A - origen) * direccion) / (direccion * direccion);
+            if (punto.colisiono && t < t_esperado)
+                esperada = e, t_esperado = t;
+        }
+
+        qt::Impacto impacto = qt.raycast(origen, direccion);
+        ASSERT_EQ(impacto.entidad, esperada);
+        if (esperada != nullptr)
+        {
+            impactos++;
+            ASSERT_NEAR(impacto.t, t_esperado, 1e-5f);
+            ASSERT_TRUE(impacto.punto.colisiono);
+            ASSERT_EQ(impacto.punto.normal.modulo_cuadrado(), 1.0f);
+        }
+    }
+
+    ASSERT_GT(impactos, 0);
+
+    qt::Impacto afuera = qt.raycast(Vector2(200.0f, 200.0f), Vector2(1.0f, .0f), 50.0f);
+    ASSERT_EQ(afuera.entidad, nullptr);
+
+    for (qt::Entidad *e : entidades)
+        delete e;
+    for (AABB *c : cajas)
+        delete c;
+    for (Circulo *c : granos)
+        delete c;
+    for (Circulo *c : rayos)
+        delete c;
+}
+
+TEST(QuadtreeTest, Un_arbol_configurado_encuentra_lo_mismo_y_respeta_la_profundidad)
+{
+    AABB area(Vector2(), 128.0f, 128.0f);
+    qt::QuadTree comun(area);
+    qt::QuadTree<Entidad, 16, 3> configurado(area);
+
+    std::vector<Circulo *> cuerpos = crear_granos(1000, 120.0f, 11);
+    std::vector<Entidad *> entidades_comun, entidades_configurado;
+    for (Circulo *c : cuerpos)
+    {
+        entidades_comun.emplace_back(new Entidad(c));
+        entidades_configurado.emplace_back(new Entidad(c));
+        comun.insertar(entidades_comun.back());
+        configurado.insertar(entidades_configurado.back());
+    }
+
+    for (int i = 0; i < 50; i++)
+    {
+        Circulo region(cuerpos[i]->m_posicion, 20.0f);
+        std::vector<Circulo *> esperados, encontrados;
+        for (qt::Entidad *e : comun.buscar(&region))
+            esperados.emplace_back((Circulo *)((Entidad *)e)->m_cuerpo);
+        for (Entidad *e : configurado.buscar(&region))
+            encontrados.emplace_back((Circulo *)e->m_cuerpo);
+
+        std::sort(esperados.begin(), esperados.end());
+        std::sort(encontrados.begin(), encontrados.end());
+        ASSERT_EQ(encontrados, esperados);
+    }
+
+    // Aunque todas esten en el mismo punto, no se baja de la profundidad maxima
+    qt::QuadTree<Entidad, 1, 3> poco_profundo(area);
+    Circulo punto(Vector2(10.0f, 10.0f), 1.0f);
+    std::vector<Entidad *> apiladas;
+    for (int i = 0; i < 20; i++)
+    {
+        apiladas.emplace_back(new Entidad(&punto));
+        ASSERT_TRUE(poco_profundo.insertar(apiladas.back()));
+    }
+    ASSERT_LE(poco_profundo.pool().vivos(), 4 * 3);
+
+    for (Entidad *e : apiladas)
+        delete e;
+    for (size_t i = 0; i < cuerpos.size(); i++)
+    {
+        delete entidades_comun[i];
+        delete entidades_configurado[i];
+        delete cuerpos[i];
+    }
+}
+
+TEST(QuadtreeTest, Al_actualizar_sin_cambiar_de_hoja_se_refrescan_los_limites_guardados)
+{
+    AABB area(Vector2(), 64.0f, 64.0f);
+    qt::QuadTree de_a_una(area), en_lote(area);
+
+    Circulo cuerpo_una(Vector2(20.0f, 20.0f), 1.0f), cuerpo_lote(Vector2(20.0f, 20.0f), 1.0f);
+    Entidad una(&cuerpo_una), lote(&cuerpo_lote);
+    de_a_una.insertar(&una);
+    en_lote.insertar(&lote);
+    qt::Node *hoja_una = una.m_padres[0], *hoja_lote = lote.m_padres[0];
+
+    // Se mueven poco, sin salir de su hoja, hasta donde la caja vieja ya no llega
+    cuerpo_una.m_posicion = Vector2(26.0f, 20.0f);
+    cuerpo_lote.m_posicion = Vector2(26.0f, 20.0f);
+    de_a_una.actualizar(&una);
+    std::vector<qt::Entidad *> entidades = {&lote};
+    en_lote.actualizar_lote(entidades);
+    ASSERT_EQ(una.m_padres[0], hoja_una);
+    ASSERT_EQ(lote.m_padres[0], hoja_lote);
+
+    AABB cerca_nueva(Vector2(28.0f, 20.0f), 1.5f, 1.5f);
+    AABB cerca_vieja(Vector2(18.0f, 20.0f), 1.5f, 1.5f);
+    ASSERT_EQ(de_a_una.buscar(&cerca_nueva).size(), 1);
+    ASSERT_EQ(en_lote.buscar(&cerca_nueva).size(), 1);
+    ASSERT_EQ(de_a_una.buscar(&cerca_vieja).size(), 0);
+    ASSERT_EQ(en_lote.buscar(&cerca_vieja).size(), 0);
+}
+
+TEST(QuadtreeTest, Al_juntar_un_nodo_no_se_pierden_las_entidades_que_tambien_estan_afuera)
+{
+    qt::QuadTree qt(Vector2(), 64.0f, 64.0f);
+
+    // Queda en el limite entre los dos cuadrantes de arriba
+    Circulo cuerpo_en_limite(Vector2(.0f, 20.0f), 1.0f);
+    Entidad en_limite(&cuerpo_en_limite);
+
+    std::vector<Circulo> cuerpos = {
+        Circulo(Vector2(-30.0f, 30.0f), 1.0f), Circulo(Vector2(-40.0f, 40.0f), 1.0f),
+        Circulo(Vector2(-20.0f, 50.0f), 1.0f), Circulo(Vector2(-50.0f, 10.0f), 1.0f),
+        Circulo(Vector2(-30.0f, -30.0f), 1.0f), Circulo(Vector2(30.0f, -30.0f), 1.0f),
+        Circulo(Vector2(-40.0f, -40.0f), 1.0f), Circulo(Vector2(40.0f, -40.0f), 1.0f),
+    };
+    std::vector<Entidad> entidades;
+    for (Circulo &cuerpo : cuerpos)
+        entidades.emplace_back(&cuerpo);
+
+    qt.insertar(&en_limite);
+    for (Entidad &entidad : entidades)
+        qt.insertar(&entidad);
+
+    // El cuadrante de arriba a la izquierda queda con pocas y se junta
+    qt.eliminar(&entidades[0]);
+    qt.eliminar(&entidades[1]);
+
+    Circulo a_la_izquierda(Vector2(-.5f, 20.0f), .4f);
+    Circulo a_la_derecha(Vector2(.5f, 20.0f), .4f);
+    ASSERT_EQ(qt.buscar(&a_la_izquierda).size(), 1);
+    ASSERT_EQ(qt.buscar(&a_la_derecha).size(), 1);
+}
@@ -622,3 +622,511 @@ TEST(SistemaTest, Una_particula_choca_contra_la_esquina_y_el_choque_es_plastico_
     for (Particula *p : particulas)
         delete p;
 }
+
+TEST(SistemaTest, El_store_guarda_las_particulas_por_indice_sin_repetirlas)
+{
+    std::vector<Particula *> particulas;
+    Particula *particula = new Particula(2.0f, Vector2(1.0f, .0f), Vector2(.0f, -10.0f), 1.0f);
+    Particula *piso = new Particula();
+
+    particulas.emplace_back(particula);
+    particulas.emplace_back(piso);
+    particulas.emplace_back(particula);
+
+    Sistema sistema(particulas, 1.0f);
+    const ParticleStore &store = sistema.store();
+
+    ASSERT_EQ(store.cantidad(), 2);
+    ASSERT_EQ(particula->m_indice, 0);
+    ASSERT_EQ(piso->m_indice, 1);
+    ASSERT_NEAR(store.m_inversa_masa[0], .5f, .0001f);
+    ASSERT_NEAR(store.m_inversa_masa[1], .0f, .0001f);
+    ASSERT_TRUE(store.m_estatica[1]);
+
+    for (Particula *p : {particula, piso})
+        delete p;
+}
+
+TEST(SistemaTest, Una_particula_sin_interacciones_acumula_la_fuerza_aplicada_en_cada_paso)
+{
+    std::vector<Particula *> particulas;
+    Particula *particula = new Particula(2.0f, Vector2(), Vector2(.0f, -10.0f), 1.0f);
+    particulas.emplace_back(particula);
+
+    Sistema sistema(particulas, 1.0f);
+
+    sistema.expandir_interacciones();
+    ASSERT_EQ(particula->m_velocidad, Vector2(.0f, -5.0f));
+    ASSERT_EQ(particula->m_fuerza, Vector2());
+
+    sistema.aplicar_fuerza(particula, Vector2(.0f, -10.0f));
+    sistema.expandir_interacciones();
+    ASSERT_EQ(particula->m_velocidad, Vector2(.0f, -10.0f));
+
+    delete particula;
+}
+
+TEST(SistemaTest, El_grafo_guarda_cada_contacto_una_sola_vez_con_su_direccion)
+{
+    GrafoDeInteracciones grafo;
+    grafo.agregar(2, 0, Vector2(.0f, 1.0f), 1.0f);
+    grafo.agregar(0, 2, Vector2(.0f, -1.0f), 1.0f);
+    grafo.agregar(1, 2, Vector2(1.0f, .0f), 1.0f);
+    grafo.agregar(1, 1, Vector2(1.0f, .0f), 1.0f);
+    grafo.construir(3);
+
+    ASSERT_EQ(grafo.cantidad_aristas(), 2);
+    ASSERT_EQ(grafo.m_a[0], 0);
+    ASSERT_EQ(grafo.m_b[0], 2);
+    ASSERT_EQ(grafo.direccion(0, 0), Vector2(.0f, -1.0f));
+    ASSERT_EQ(grafo.direccion(0, 2), Vector2(.0f, 1.0f));
+
+    ASSERT_EQ(grafo.m_desplazamientos, std::vector<int>({0, 1, 2, 4}));
+    ASSERT_EQ(grafo.otra(grafo.m_incidencias[1], 1), 2);
+}
+
+TEST(SistemaTest, Alcanza_con_agregar_la_interaccion_en_una_sola_direccion)
+{
+    std::vector<Particula *> particulas;
+    Particula *particula = new Particula(1.0f, Vector2(.0f, -10.0f), Vector2(.0f, -10.0f), 1.0f);
+    Particula *piso = new Particula();
+
+    particulas.emplace_back(particula);
+    particulas.emplace_back(piso);
+
+    Sistema sistema(particulas, 1.0f);
+
+    Vector2 dir_abajo(.0f, -1.0f);
+    sistema.agregar_interaccion(particula, piso, dir_abajo);
+
+    sistema.expandir_interacciones();
+
+    ASSERT_EQ(particula->m_velocidad, Vector2(.0f, 10.0f));
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+std::vector<Particula *> crear_pila(int filas, int columnas)
+{
+    std::vector<Particula *> particulas;
+    for (int i = 0; i < filas * columnas; i++)
+    {
+        Vector2 velocidad((float)(i * 7 % 5) - 2.0f, (float)(i * 3 % 4) - 2.0f);
+        particulas.emplace_back(new Particula(1.0f + (float)(i % 3), velocidad, Vector2(.0f, -10.0f), .25f * (float)(i % 4)));
+    }
+    particulas.emplace_back(new Particula());
+    return particulas;
+}
+
+void conectar_pila(Sistema &sistema, int filas, int columnas)
+{
+    int piso = filas * columnas;
+    for (int fila = 0; fila < filas; fila++)
+        for (int columna = 0; columna < columnas; columna++)
+        {
+            int indice = fila * columnas + columna;
+            if (columna + 1 < columnas)
+                sistema.agregar_interaccion(indice, indice + 1, Vector2(1.0f, .0f));
+            if (fila + 1 < filas)
+                sistema.agregar_interaccion(indice, indice + columnas, Vector2(.0f, -1.0f));
+            else
+                sistema.agregar_interaccion(indice, piso, Vector2(.0f, -1.0f));
+        }
+}
+
+TEST(SistemaTest, El_coloreo_no_repite_particulas_dinamicas_en_un_mismo_color)
+{
+    int filas = 6, columnas = 5;
+    std::vector<Particula *> particulas = crear_pila(filas, columnas);
+    Sistema sistema(particulas, 1.0f);
+    conectar_pila(sistema, filas, columnas);
+
+    sistema.usar_modo(ModoDelSolver::Coloreado);
+    sistema.expandir_interacciones();
+
+    const GrafoDeInteracciones &grafo = sistema.grafo();
+    const ParticleStore &store = sistema.store();
+    ASSERT_TRUE(grafo.coloreado());
+
+    for (int color = 0; color < grafo.cantidad_colores(); color++)
+    {
+        std::vector<int> usada(store.cantidad(), 0);
+        for (int i = grafo.m_desplazamientos_color[color]; i < grafo.m_desplazamientos_color[color + 1]; i++)
+        {
+            int arista = grafo.m_aristas_por_color[i];
+            for (int extremo : {grafo.m_a[arista], grafo.m_b[arista]})
+            {
+                if (!store.m_estatica[extremo])
+                {
+                    ASSERT_EQ(usada[extremo]++, 0);
+                }
+            }
+        }
+    }
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, El_modo_coloreado_da_el_mismo_resultado_que_el_modo_serial)
+{
+    int filas = 12, columnas = 9;
+    std::vector<Particula *> serial = crear_pila(filas, columnas);
+    std::vector<Particula *> coloreado = crear_pila(filas, columnas);
+
+    Sistema sistema_serial(serial, 1.0f);
+    Sistema sistema_coloreado(coloreado, 1.0f);
+    conectar_pila(sistema_serial, filas, columnas);
+    conectar_pila(sistema_coloreado, filas, columnas);
+    sistema_coloreado.usar_modo(ModoDelSolver::Coloreado);
+
+    sistema_serial.expandir_interacciones();
+    sistema_coloreado.expandir_interacciones();
+
+    for (int i = 0; i < (int)serial.size(); i++)
+        ASSERT_EQ(serial[i]->m_velocidad, coloreado[i]->m_velocidad);
+
+    for (Particula *p : serial)
+        delete p;
+    for (Particula *p : coloreado)
+        delete p;
+}
+
+TEST(SistemaTest, Dos_pilas_sobre_el_mismo_piso_forman_dos_islas_ordenadas_de_mayor_a_menor)
+{
+    std::vector<Particula *> particulas;
+    for (int i = 0; i < 6; i++)
+        particulas.emplace_back(new Particula(1.0f, Vector2(), Vector2(.0f, -10.0f), 1.0f));
+    particulas.emplace_back(new Particula());
+
+    Sistema sistema(particulas, 1.0f);
+
+    // pila chica: 0 sobre 1, pila grande: 2 sobre 3 sobre 4, y 5 cae sola
+    Vector2 dir_abajo(.0f, -1.0f);
+    sistema.agregar_interaccion(0, 1, dir_abajo);
+    sistema.agregar_interaccion(1, 6, dir_abajo);
+    sistema.agregar_interaccion(2, 3, dir_abajo);
+    sistema.agregar_interaccion(3, 4, dir_abajo);
+    sistema.agregar_interaccion(4, 6, dir_abajo);
+
+    sistema.expandir_interacciones();
+
+    const GrafoDeInteracciones &grafo = sistema.grafo();
+    ASSERT_EQ(grafo.cantidad_islas(), 2);
+    ASSERT_EQ(grafo.m_isla[2], 0);
+    ASSERT_EQ(grafo.m_isla[0], 1);
+    ASSERT_EQ(grafo.m_isla[5], -1);
+    ASSERT_EQ(grafo.m_isla[6], -1);
+
+    for (int i = 0; i < 5; i++)
+        ASSERT_EQ(particulas[i]->m_velocidad, Vector2());
+    ASSERT_EQ(particulas[5]->m_velocidad, Vector2(.0f, -10.0f));
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, El_modo_por_islas_da_el_mismo_resultado_que_el_modo_serial)
+{
+    int filas = 8, columnas = 4;
+    std::vector<Particula *> serial = crear_pila(filas, columnas);
+    std::vector<Particula *> islas = crear_pila(filas, columnas);
+
+    Sistema sistema_serial(serial, 1.0f);
+    Sistema sistema_islas(islas, 1.0f);
+    sistema_serial.usar_modo(ModoDelSolver::Serial);
+    sistema_islas.usar_modo(ModoDelSolver::Islas);
+
+    // cada columna es una pila separada sobre el mismo piso
+    int piso = filas * columnas;
+    for (Sistema *sistema : {&sistema_serial, &sistema_islas})
+        for (int fila = 0; fila < filas; fila++)
+            for (int columna = 0; columna < columnas; columna++)
+            {
+                int indice = fila * columnas + columna;
+                int abajo = (fila + 1 < filas) ? indice + columnas : piso;
+                sistema->agregar_interaccion(indice, abajo, Vector2(.0f, -1.0f));
+            }
+
+    sistema_serial.expandir_interacciones();
+    sistema_islas.expandir_interacciones();
+
+    ASSERT_EQ(sistema_islas.grafo().cantidad_islas(), columnas);
+    for (int i = 0; i < (int)serial.size(); i++)
+        ASSERT_EQ(serial[i]->m_velocidad, islas[i]->m_velocidad);
+
+    for (Particula *p : serial)
+        delete p;
+    for (Particula *p : islas)
+        delete p;
+}
+
+TEST(SistemaTest, Una_pila_quieta_se_duerme_junta_y_se_despierta_al_aplicarle_una_fuerza)
+{
+    std::vector<Particula *> particulas;
+    Particula *arriba = new Particula(1.0f, Vector2(), Vector2(), 1.0f);
+    Particula *abajo = new Particula(1.0f, Vector2(), Vector2(), 1.0f);
+    Particula *piso = new Particula();
+
+    particulas.emplace_back(arriba);
+    particulas.emplace_back(abajo);
+    particulas.emplace_back(piso);
+
+    Sistema sistema(particulas, .1f);
+    sistema.configurar_sueno(.1f, 3);
+
+    Vector2 dir_abajo(.0f, -1.0f);
+    sistema.agregar_interaccion(arriba, abajo, dir_abajo);
+    sistema.agregar_interaccion(abajo, piso, dir_abajo);
+
+    for (int cuadro = 0; cuadro < 2; cuadro++)
+    {
+        sistema.aplicar_gravedad(Vector2(.0f, -10.0f));
+        sistema.expandir_interacciones();
+        ASSERT_FALSE(sistema.dormida(arriba));
+        ASSERT_EQ(sistema.estadisticas().dormidas, 0);
+    }
+
+    sistema.aplicar_gravedad(Vector2(.0f, -10.0f));
+    sistema.expandir_interacciones();
+    ASSERT_TRUE(sistema.dormida(arriba));
+    ASSERT_TRUE(sistema.dormida(abajo));
+    ASSERT_EQ(sistema.estadisticas().dormidas, 2);
+    ASSERT_EQ(sistema.estadisticas().total_dormidas, 2);
+
+    sistema.aplicar_gravedad(Vector2(.0f, -10.0f));
+    sistema.expandir_interacciones();
+    ASSERT_TRUE(sistema.dormida(arriba));
+    ASSERT_EQ(sistema.estadisticas().dormidas, 0);
+
+    sistema.aplicar_fuerza(arriba, Vector2(10.0f, .0f));
+    sistema.expandir_interacciones();
+    ASSERT_FALSE(sistema.dormida(arriba));
+    ASSERT_FALSE(sistema.dormida(abajo));
+    ASSERT_EQ(sistema.estadisticas().despertadas, 2);
+    ASSERT_EQ(arriba->m_velocidad, Vector2(1.0f, .0f));
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, Una_particula_que_cae_sobre_una_pila_dormida_despierta_a_toda_la_isla)
+{
+    std::vector<Particula *> particulas;
+    Particula *cayendo = new Particula(1.0f, Vector2(.0f, -5.0f), Vector2(), 1.0f);
+    Particula *arriba = new Particula(1.0f, Vector2(), Vector2(), 1.0f);
+    Particula *abajo = new Particula(1.0f, Vector2(), Vector2(), 1.0f);
+    Particula *piso = new Particula();
+
+    particulas.emplace_back(cayendo);
+    particulas.emplace_back(arriba);
+    particulas.emplace_back(abajo);
+    particulas.emplace_back(piso);
+
+    Sistema sistema(particulas, .1f);
+    sistema.configurar_sueno(.1f, 1);
+
+    Vector2 dir_abajo(.0f, -1.0f);
+    sistema.agregar_interaccion(arriba, abajo, dir_abajo);
+    sistema.agregar_interaccion(abajo, piso, dir_abajo);
+
+    sistema.aplicar_gravedad(Vector2(.0f, -10.0f));
+    sistema.expandir_interacciones();
+    ASSERT_TRUE(sistema.dormida(arriba));
+    ASSERT_TRUE(sistema.dormida(abajo));
+    ASSERT_FALSE(sistema.dormida(cayendo));
+
+    sistema.agregar_interaccion(cayendo, arriba, dir_abajo);
+    sistema.expandir_interacciones();
+    ASSERT_EQ(sistema.estadisticas().despertadas, 2);
+    ASSERT_FALSE(sistema.dormida(arriba));
+    ASSERT_FALSE(sistema.dormida(abajo));
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, En_un_cumulo_denso_el_modo_serial_con_epocas_da_lo_mismo_que_el_modo_coloreado)
+{
+    int cantidad = 12;
+    std::vector<Particula *> serial = crear_pila(cantidad, 1);
+    std::vector<Particula *> coloreado = crear_pila(cantidad, 1);
+
+    Sistema sistema_serial(serial, 1.0f);
+    Sistema sistema_coloreado(coloreado, 1.0f);
+    sistema_serial.usar_modo(ModoDelSolver::Serial);
+    sistema_coloreado.usar_modo(ModoDelSolver::Coloreado);
+
+    for (Sistema *sistema : {&sistema_serial, &sistema_coloreado})
+        for (int i = 0; i < cantidad; i++)
+        {
+            Vector2 posicion_i((float)(i % 4), (float)(i / 4));
+            for (int j = i + 1; j < cantidad; j++)
+            {
+                Vector2 posicion_j((float)(j % 4), (float)(j / 4));
+                sistema->agregar_interaccion(i, j, (posicion_j - posicion_i).normal());
+            }
+            if (i < 4)
+                sistema->agregar_interaccion(i, cantidad, Vector2(.0f, -1.0f));
+        }
+
+    sistema_serial.expandir_interacciones();
+    sistema_coloreado.expandir_interacciones();
+
+    bool hubo_visitas = false;
+    for (uint32_t visita : sistema_serial.grafo().m_visita)
+        hubo_visitas |= visita > 0;
+    ASSERT_TRUE(hubo_visitas);
+
+    for (int i = 0; i < (int)serial.size(); i++)
+        ASSERT_EQ(serial[i]->m_velocidad, coloreado[i]->m_velocidad);
+
+    for (Particula *p : serial)
+        delete p;
+    for (Particula *p : coloreado)
+        delete p;
+}
+
+TEST(SistemaTest, El_modo_ordenado_sostiene_una_pila_alta_en_una_cantidad_constante_de_pasadas)
+{
+    int altura = 25;
+    std::vector<Particula *> serial, ordenado;
+    for (std::vector<Particula *> *particulas : {&serial, &ordenado})
+    {
+        for (int i = 0; i < altura; i++)
+            particulas->emplace_back(new Particula(1.0f, Vector2(), Vector2(.0f, -10.0f), 1.0f));
+        particulas->emplace_back(new Particula());
+    }
+
+    Sistema sistema_serial(serial, 1.0f);
+    Sistema sistema_ordenado(ordenado, 1.0f);
+    sistema_serial.usar_modo(ModoDelSolver::Serial);
+    sistema_ordenado.usar_modo(ModoDelSolver::Ordenado);
+
+    for (Sistema *sistema : {&sistema_serial, &sistema_ordenado})
+        for (int i = 0; i < altura; i++)
+            sistema->agregar_interaccion(i, i + 1, Vector2(.0f, -1.0f));
+
+    sistema_serial.expandir_interacciones();
+    sistema_ordenado.expandir_interacciones();
+
+    bool sostenida = true;
+    for (Particula *p : serial)
+        sostenida &= p->m_velocidad == Vector2();
+    ASSERT_EQ(sistema_serial.estadisticas().pasadas, 10);
+    ASSERT_FALSE(sostenida);
+
+    ASSERT_EQ(sistema_ordenado.grafo().m_altura[0], altura);
+    ASSERT_LE(sistema_ordenado.estadisticas().pasadas, 2);
+    for (Particula *p : ordenado)
+        ASSERT_EQ(p->m_velocidad, Vector2());
+
+    for (Particula *p : serial)
+        delete p;
+    for (Particula *p : ordenado)
+        delete p;
+}
+
+std::vector<Particula *> crear_columna(int altura)
+{
+    std::vector<Particula *> particulas;
+    for (int i = 0; i < altura; i++)
+        particulas.emplace_back(new Particula(1.0f, Vector2(), Vector2(.0f, -10.0f), 1.0f));
+    particulas.emplace_back(new Particula());
+    return particulas;
+}
+
+TEST(SistemaTest, Expandir_interacciones_devuelve_las_estadisticas_del_paso)
+{
+    int altura = 3;
+    std::vector<Particula *> particulas = crear_columna(altura);
+    Sistema sistema(particulas, 1.0f);
+    sistema.usar_modo(ModoDelSolver::Serial);
+    for (int i = 0; i < altura; i++)
+        sistema.agregar_interaccion(i, i + 1, Vector2(.0f, -1.0f));
+
+    Estadisticas estadisticas = sistema.expandir_interacciones();
+
+    ASSERT_TRUE(estadisticas.convergio);
+    ASSERT_EQ(estadisticas.residuo, .0f);
+    ASSERT_EQ(estadisticas.aristas_activas, altura);
+    ASSERT_LE(estadisticas.pasadas, 10);
+    ASSERT_GE(estadisticas.tiempo.count(), 0);
+    ASSERT_EQ(estadisticas.pasadas, sistema.estadisticas().pasadas);
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, Con_un_maximo_de_iteraciones_el_solver_corta_sin_converger)
+{
+    int altura = 25;
+    for (ModoDelSolver modo : {ModoDelSolver::Serial, ModoDelSolver::Islas, ModoDelSolver::Coloreado})
+    {
+        std::vector<Particula *> particulas = crear_columna(altura);
+        Sistema sistema(particulas, 1.0f);
+
+        ConfiguracionDelSolver configuracion;
+        configuracion.modo = modo;
+        configuracion.maximo_de_iteraciones = 3;
+        sistema.configurar_solver(configuracion);
+        for (int i = 0; i < altura; i++)
+            sistema.agregar_interaccion(i, i + 1, Vector2(.0f, -1.0f));
+
+        Estadisticas estadisticas = sistema.expandir_interacciones();
+
+        ASSERT_EQ(estadisticas.pasadas, 3);
+        ASSERT_FALSE(estadisticas.convergio);
+        ASSERT_GT(estadisticas.residuo, .0f);
+
+        for (Particula *p : particulas)
+            delete p;
+    }
+}
+
+TEST(SistemaTest, Con_una_tolerancia_mayor_al_residuo_alcanza_una_sola_iteracion)
+{
+    int altura = 25;
+    std::vector<Particula *> particulas = crear_columna(altura);
+    Sistema sistema(particulas, 1.0f);
+
+    ConfiguracionDelSolver configuracion;
+    configuracion.modo = ModoDelSolver::Serial;
+    configuracion.tolerancia = 1000.0f;
+    sistema.configurar_solver(configuracion);
+    for (int i = 0; i < altura; i++)
+        sistema.agregar_interaccion(i, i + 1, Vector2(.0f, -1.0f));
+
+    Estadisticas estadisticas = sistema.expandir_interacciones();
+
+    ASSERT_EQ(estadisticas.pasadas, 1);
+    ASSERT_TRUE(estadisticas.convergio);
+    ASSERT_GT(estadisticas.residuo, .0f);
+    ASSERT_LE(estadisticas.residuo, 1000.0f);
+
+    for (Particula *p : particulas)
+        delete p;
+}
+
+TEST(SistemaTest, Con_el_presupuesto_agotado_el_solver_hace_una_sola_iteracion)
+{
+    int altura = 25;
+    std::vector<Particula *> particulas = crear_columna(altura);
+    Sistema sistema(particulas, 1.0f);
+
+    ConfiguracionDelSolver configuracion;
+    configuracion.modo = ModoDelSolver::Serial;
+    configuracion.presupuesto = std::chrono::nanoseconds(1);
+    sistema.configurar_solver(configuracion);
+    for (int i = 0; i < altura; i++)
+        sistema.agregar_interaccion(i, i + 1, Vector2(.0f, -1.0f));
+
+    Estadisticas estadisticas = sistema.expandir_interacciones();
+
+    ASSERT_LT(estadisticas.pasadas, 10);
+    ASSERT_FALSE(estadisticas.convergio);
+
+    for (Particula *p : particulas)
+        delete p;
+}
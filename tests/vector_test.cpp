@@ -215,4 +215,51 @@ TEST(VectorTest, calcular_la_normal_de_un_vector)
 
     ASSERT_NEAR(resultado.x, x, 0.01f);
     ASSERT_NEAR(resultado.y, y, 0.01f);
-}
\ No newline at end of file
+}
+
+TEST(VectorTest, Las_operaciones_se_pueden_hacer_en_tiempo_de_compilacion)
+{
+    constexpr Vector2 vector(3.0f, 4.0f), otro(1.0f, .0f);
+
+    static_assert(vector.modulo_cuadrado() == 25.0f);
+    static_assert(vector.distancia_cuadrada(otro) == 20.0f);
+    static_assert(vector * otro == 3.0f);
+    static_assert(vector.proyeccion(otro) == Vector2(3.0f, .0f));
+    static_assert(!vector.nulo());
+}
+
+TEST(VectorTest, Las_operaciones_del_lote_coinciden_con_las_de_cada_vector)
+{
+    Vector2Batch lote, otro;
+    for (int i = 0; i < 37; i++)
+    {
+        lote.agregar(Vector2(.5f * i - 7.0f, 3.0f - .25f * i));
+        otro.agregar(Vector2(1.0f + i % 5, .3f * i));
+    }
+    lote.asignar(10, Vector2());
+    Vector2Batch original = lote;
+
+    std::vector<float> productos(lote.cantidad());
+    lote.producto_escalar(otro, productos.data());
+    Vector2Batch proyectados;
+    lote.proyeccion(otro, proyectados);
+
+    Vector2Batch normalizados = lote;
+    normalizados.normalizar();
+
+    lote += otro;
+    lote *= 2.0f;
+    lote += Vector2(1.0f, -1.0f);
+
+    for (int i = 0; i < lote.cantidad(); i++)
+    {
+        Vector2 vector = original[i];
+        ASSERT_FLOAT_EQ(productos[i], vector * otro[i]);
+        ASSERT_EQ(proyectados[i], vector.proyeccion(otro[i]));
+        ASSERT_EQ(normalizados[i], vector.normal());
+        ASSERT_EQ(lote[i], (vector + otro[i]) * 2.0f + Vector2(1.0f, -1.0f));
+    }
+
+    lote -= lote;
+    ASSERT_TRUE(lote[5].nulo());
+}